@@ -0,0 +1,279 @@
+#include "ndcube.h"
+
+#include <cstring>
+#include <new>
+#include <span>
+
+#include "ndcube.hpp"
+
+struct ndcube_cube {
+    virtual ~ndcube_cube() = default;
+    virtual auto dims() const -> int = 0;
+    virtual auto clone() const -> ndcube_cube* = 0;
+    virtual auto apply(std::span<const uint16_t> moves) -> ndcube_status = 0;
+    virtual auto is_solved() const -> bool = 0;
+    // towards target, of the same dims, or the solved state when it is null.
+    virtual auto solve(const SolveOptions& opts, const ndcube_cube* target) const
+        -> std::optional<std::vector<uint16_t>> = 0;
+};
+
+struct ndcube_solution {
+    std::vector<uint16_t> moves;
+};
+
+namespace {
+
+template <dim_t DIMS>
+struct Handle final : ndcube_cube {
+    // on the heap with the handle, since Cube<DIMS> grows as 3^DIMS.
+    Cube<DIMS> cube;
+
+    auto dims() const -> int override {
+        return DIMS;
+    }
+
+    auto clone() const -> ndcube_cube* override {
+        return new Handle(*this);
+    }
+
+    auto apply(std::span<const uint16_t> moves) -> ndcube_status override {
+        let& table = every_move<DIMS>();
+        if (std::any_of(moves.begin(), moves.end(), [&](auto m) { return m >= table.size(); })) {
+            return NDCUBE_INVALID_ARGUMENT;
+        }
+        for (let m : moves) {
+            cube.rotate(table.moves[m]);
+        }
+        return NDCUBE_OK;
+    }
+
+    auto is_solved() const -> bool override {
+        return cube.is_solved();
+    }
+
+    auto solve(const SolveOptions& opts, const ndcube_cube* target) const
+        -> std::optional<std::vector<uint16_t>> override {
+        let solution =
+            target ? solve_between(cube, static_cast<const Handle*>(target)->cube, opts) : ::solve(cube, opts);
+        if (!solution) {
+            return std::nullopt;
+        }
+        let& table = every_move<DIMS>();
+        std::vector<uint16_t> ids;
+        for (let r : *solution) {
+            ids.push_back(table.id_of(r));
+        }
+        return ids;
+    }
+};
+
+auto valid_dims(int dims) -> bool {
+    return dims >= MIN_DIMS && dims <= MAX_DIMS;
+}
+
+static_assert((int)Metric::QUARTER == NDCUBE_METRIC_QUARTER && (int)Metric::SLICE == NDCUBE_METRIC_SLICE &&
+              (int)Metric::HALF == NDCUBE_METRIC_HALF);
+
+auto move_id(int dims, int axis, int from, int to, int side, int turns) -> int {
+    if (!valid_dims(dims)) {
+        return -1;
+    }
+    let all = with_dims(dims, [](auto D) { return Rotation::every<decltype(D)::value>(); });
+    let at = std::find_if(all.begin(), all.end(), [&](let& r) {
+        return r.axis == axis && r.side == side && r.turns == turns &&
+               ((r.from == from && r.to == to) || (turns == 2 && r.from == to && r.to == from));
+    });
+    return at == all.end() ? -1 : (int)(at - all.begin());
+}
+
+// nothing may unwind into C.
+template <class F>
+auto guarded(F&& f) -> ndcube_status {
+    try {
+        return f();
+    } catch (...) {
+        return NDCUBE_INTERNAL_ERROR;
+    }
+}
+
+}  // namespace
+
+extern "C" {
+
+int ndcube_api_version(void) {
+    return NDCUBE_API_VERSION;
+}
+
+int ndcube_min_dims(void) {
+    return MIN_DIMS;
+}
+
+int ndcube_max_dims(void) {
+    return MAX_DIMS;
+}
+
+ndcube_cube* ndcube_create(int dims) {
+    if (!valid_dims(dims)) {
+        return nullptr;
+    }
+    return with_dims(dims, [](auto D) -> ndcube_cube* {
+        return new (std::nothrow) Handle<decltype(D)::value>();
+    });
+}
+
+ndcube_cube* ndcube_clone(const ndcube_cube* cube) {
+    if (!cube) {
+        return nullptr;
+    }
+    try {
+        return cube->clone();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void ndcube_destroy(ndcube_cube* cube) {
+    delete cube;
+}
+
+int ndcube_dims(const ndcube_cube* cube) {
+    return cube ? cube->dims() : 0;
+}
+
+size_t ndcube_num_moves(int dims) {
+    if (!valid_dims(dims)) {
+        return 0;
+    }
+    return with_dims(dims, [](auto D) { return Rotation::all<decltype(D)::value>().size(); });
+}
+
+int ndcube_move_id(int dims, int axis, int from, int to, int side) {
+    return move_id(dims, axis, from, to, side, 1);
+}
+
+int ndcube_half_turn_id(int dims, int axis, int from, int to, int side) {
+    return move_id(dims, axis, from, to, side, 2);
+}
+
+ndcube_status ndcube_apply(ndcube_cube* cube, const uint16_t* moves, size_t count) {
+    if (!cube || (!moves && count > 0)) {
+        return NDCUBE_INVALID_ARGUMENT;
+    }
+    return guarded([&] { return cube->apply({moves, count}); });
+}
+
+int ndcube_is_solved(const ndcube_cube* cube) {
+    return cube && cube->is_solved();
+}
+
+void ndcube_solve_options_init(ndcube_solve_options* options) {
+    if (!options) {
+        return;
+    }
+    let defaults = SolveOptions{};
+    options->size = sizeof(ndcube_solve_options);
+    options->max_depth = defaults.max_depth;
+    options->dual = defaults.dual;
+    options->allow_fallback = defaults.allow_fallback;
+    options->metric = (int)defaults.metric;
+}
+
+namespace {
+
+// only read as much of the options as the caller knew about.
+auto read_options(const ndcube_solve_options* options, SolveOptions& opts) -> ndcube_status {
+    ndcube_solve_options given;
+    ndcube_solve_options_init(&given);
+    if (options) {
+        if (options->size < sizeof(size_t)) {
+            return NDCUBE_INVALID_ARGUMENT;
+        }
+        std::memcpy(&given, options, std::min(options->size, sizeof(given)));
+    }
+    if (given.metric < NDCUBE_METRIC_QUARTER || given.metric > NDCUBE_METRIC_HALF) {
+        return NDCUBE_INVALID_ARGUMENT;
+    }
+    opts = SolveOptions{
+        .max_depth = given.max_depth,
+        .dual = given.dual != 0,
+        .allow_fallback = given.allow_fallback != 0,
+        .metric = (Metric)given.metric,
+    };
+    return NDCUBE_OK;
+}
+
+auto solve_handle(const ndcube_cube* cube, const ndcube_cube* target, const ndcube_solve_options* options,
+                  ndcube_solution** out) -> ndcube_status {
+    SolveOptions opts;
+    if (let status = read_options(options, opts); status != NDCUBE_OK) {
+        return status;
+    }
+    return guarded([&] {
+        auto moves = cube->solve(opts, target);
+        if (!moves) {
+            return NDCUBE_UNSOLVED;
+        }
+        *out = new ndcube_solution{std::move(*moves)};
+        return NDCUBE_OK;
+    });
+}
+
+}  // namespace
+
+ndcube_status ndcube_prepare_for(int dims, const ndcube_solve_options* options) {
+    if (!valid_dims(dims)) {
+        return NDCUBE_INVALID_ARGUMENT;
+    }
+    SolveOptions opts;
+    if (let status = read_options(options, opts); status != NDCUBE_OK) {
+        return status;
+    }
+    return guarded([&] {
+        with_dims(dims, [&](auto D) {
+            constexpr auto DIMS = decltype(D)::value;
+            auto& tables = Tables<DIMS>::instance(opts.metric);
+            tables.moves.get();
+            tables.heuristic.get();
+            endgame_for<DIMS>(opts);
+        });
+        return NDCUBE_OK;
+    });
+}
+
+ndcube_status ndcube_prepare(int dims) {
+    return ndcube_prepare_for(dims, nullptr);
+}
+
+ndcube_status ndcube_solve(const ndcube_cube* cube, const ndcube_solve_options* options, ndcube_solution** out) {
+    if (!cube || !out) {
+        return NDCUBE_INVALID_ARGUMENT;
+    }
+    *out = nullptr;
+    return solve_handle(cube, nullptr, options, out);
+}
+
+ndcube_status ndcube_solve_between(const ndcube_cube* from, const ndcube_cube* to, const ndcube_solve_options* options,
+                                   ndcube_solution** out) {
+    if (!from || !to || !out) {
+        return NDCUBE_INVALID_ARGUMENT;
+    }
+    *out = nullptr;
+    if (from->dims() != to->dims()) {
+        return NDCUBE_INVALID_ARGUMENT;
+    }
+    return solve_handle(from, to, options, out);
+}
+
+size_t ndcube_solution_length(const ndcube_solution* solution) {
+    return solution ? solution->moves.size() : 0;
+}
+
+const uint16_t* ndcube_solution_moves(const ndcube_solution* solution) {
+    return solution ? solution->moves.data() : nullptr;
+}
+
+void ndcube_solution_free(ndcube_solution* solution) {
+    delete solution;
+}
+
+}
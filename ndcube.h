@@ -0,0 +1,101 @@
+/* C interface to the ndcube engine, for calling it in-process instead of through rubik3.
+ *
+ * Cubes are opaque handles. Moves are named by id: the index of a move in the fixed order
+ * ndcube_move_id() and ndcube_half_turn_id() report, which is the same for every build with the
+ * same API version.
+ * Face quarter turns come first, then slice quarter turns, then half turns of the faces, so
+ * ids only ever get added.
+ * Functions that can fail return an ndcube_status; nothing here throws or aborts on bad input.
+ */
+#ifndef NDCUBE_H
+#define NDCUBE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 2 added slice turns and ndcube_solve_options.metric, 3 added half turns, 4 ndcube_solve_between(),
+ * 5 ndcube_prepare_for(). */
+#define NDCUBE_API_VERSION 5
+
+typedef enum ndcube_status {
+    NDCUBE_OK = 0,
+    /* no solution within the options' max_depth. */
+    NDCUBE_UNSOLVED = 1,
+    NDCUBE_INVALID_ARGUMENT = 2,
+    NDCUBE_INTERNAL_ERROR = 3,
+} ndcube_status;
+
+/* which moves a solution may use, each counting one. */
+typedef enum ndcube_metric {
+    /* face quarter turns. */
+    NDCUBE_METRIC_QUARTER = 0,
+    /* face and inner slice quarter turns. */
+    NDCUBE_METRIC_SLICE = 1,
+    /* face quarter and half turns. */
+    NDCUBE_METRIC_HALF = 2,
+} ndcube_metric;
+
+typedef struct ndcube_cube ndcube_cube;
+typedef struct ndcube_solution ndcube_solution;
+
+typedef struct ndcube_solve_options {
+    /* sizeof(ndcube_solve_options) as the caller was compiled, so fields can be added later. */
+    size_t size;
+    int max_depth;
+    /* also bound the search by the heuristic of the inverse state. */
+    int dual;
+    /* answer with the stochastic solver while the tables for this dimension are still building. */
+    int allow_fallback;
+    /* an ndcube_metric. a cube scrambled with slice turns only solves in the slice metric. */
+    int metric;
+} ndcube_solve_options;
+
+int ndcube_api_version(void);
+
+/* the range of dimensions ndcube_create() accepts. */
+int ndcube_min_dims(void);
+int ndcube_max_dims(void);
+
+
+/* a solved cube, or NULL if dims is out of range. */
+ndcube_cube* ndcube_create(int dims);
+ndcube_cube* ndcube_clone(const ndcube_cube* cube);
+void ndcube_destroy(ndcube_cube* cube);
+
+int ndcube_dims(const ndcube_cube* cube);
+/* the number of face quarter turns. slice turns take the ids after them, then half turns. */
+size_t ndcube_num_moves(int dims);
+/* the id of turning `side` (0 or 2, or 1 for the slice between) of `axis` from `from` towards `to`,
+ * or -1 if that isn't a move. */
+int ndcube_move_id(int dims, int axis, int from, int to, int side);
+/* the same for a half turn, which is one move either way round. */
+int ndcube_half_turn_id(int dims, int axis, int from, int to, int side);
+
+/* applies every move or, if any id is out of range, none of them. */
+ndcube_status ndcube_apply(ndcube_cube* cube, const uint16_t* moves, size_t count);
+int ndcube_is_solved(const ndcube_cube* cube);
+
+void ndcube_solve_options_init(ndcube_solve_options* options);
+/* builds the tables a solve of a dims cube with these options uses now, rather than on the first
+ * such solve. each metric has its own tables. options may be NULL. */
+ndcube_status ndcube_prepare_for(int dims, const ndcube_solve_options* options);
+/* the same with the default options, so for the quarter-turn metric only. */
+ndcube_status ndcube_prepare(int dims);
+/* on NDCUBE_OK, *out holds a solution to free with ndcube_solution_free(). options may be NULL. */
+ndcube_status ndcube_solve(const ndcube_cube* cube, const ndcube_solve_options* options, ndcube_solution** out);
+/* the same, for moves that take `from` to `to`, a cube of the same dims. centres may end up turned. */
+ndcube_status ndcube_solve_between(const ndcube_cube* from, const ndcube_cube* to, const ndcube_solve_options* options,
+                                   ndcube_solution** out);
+size_t ndcube_solution_length(const ndcube_solution* solution);
+const uint16_t* ndcube_solution_moves(const ndcube_solution* solution);
+void ndcube_solution_free(ndcube_solution* solution);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
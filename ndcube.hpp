@@ -0,0 +1,4668 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <span>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/statvfs.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace cag {
+// from https://stackoverflow.com/a/19023500/13243460
+template <class Function, std::size_t... Indices>
+constexpr auto make_array_helper(Function f, std::index_sequence<Indices...>)
+    -> std::array<typename std::result_of<Function(std::size_t)>::type, sizeof...(Indices)> {
+    return {{f(Indices)...}};
+}
+
+template <int N, class Function>
+constexpr auto make_array(Function f)
+    -> std::array<typename std::result_of<Function(std::size_t)>::type, N> {
+    return make_array_helper(f, std::make_index_sequence<N>{});
+}
+}  // namespace cag
+
+#define let const auto
+#define loop while (true)
+
+using coord_t = uint8_t;
+using dim_t = uint8_t;
+
+constexpr auto X = 0, Y = 1, Z = 2, W = 3;
+constexpr auto RED = "\u001b[31m";
+constexpr auto GREEN = "\u001b[32m";
+constexpr auto RESET = "\u001b[0m";
+
+constexpr int64_t ipow(int64_t base, int exp, int64_t result = 1) {
+    return exp < 1 ? result : ipow(base * base, exp / 2, (exp % 2) ? result * base : result);
+}
+
+// splitmix64: small, fast, and the same sequence on every platform, unlike rand().
+struct SplitMix {
+    uint64_t state;
+
+    auto next() -> uint64_t {
+        auto z = (state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    // in [0, n), with a bias too small to matter here.
+    auto below(uint32_t n) -> uint32_t {
+        return (uint32_t)(next() % n);
+    }
+};
+
+enum Side {
+    FRONT = 0,
+    // the inner slice, between the two faces.
+    MIDDLE = 1,
+    BACK = 2,
+};
+
+// what a solution's length counts, and so which moves the solvers may use.
+enum class Metric : uint8_t {
+    // face quarter turns.
+    QUARTER,
+    // face and inner slice quarter turns, one move each.
+    SLICE,
+    // face quarter and half turns, one move each.
+    HALF,
+};
+
+// the furthest, in manhattan distance, one move of the metric can carry a point.
+constexpr auto max_travel(Metric metric) -> int {
+    return metric == Metric::HALF ? 4 : 2;
+}
+
+struct Rotation {
+    dim_t axis;
+    dim_t from;
+    dim_t to;
+    Side side;
+    // 1 for a quarter turn, 2 for a half turn, which is the same whichever way it goes.
+    uint8_t turns = 1;
+
+    template <dim_t DIMS>
+    static auto random() -> Rotation {
+        return random<DIMS>([](uint32_t n) { return (uint32_t)rand() % n; });
+    }
+
+    // draw(n) gives a number in [0, n).
+    template <dim_t DIMS, class Draw>
+    static auto random(Draw&& draw) -> Rotation {
+        auto side = draw(2) * 2;
+        auto axis = draw(DIMS);
+        auto from = draw(DIMS);
+        while (from == axis) {
+            from = draw(DIMS);
+        }
+        auto to = draw(DIMS);
+        while (to == axis || to == from) {
+            to = draw(DIMS);
+        }
+        return Rotation{(dim_t)axis, (dim_t)from, (dim_t)to, (Side)side};
+    }
+
+    // every legal move in the metric, in a fixed order so that a move can be named by its index.
+    // slice and half turns come after all the face quarter turns, so those keep their ids.
+    template <dim_t DIMS>
+    static auto all(Metric metric = Metric::QUARTER) -> std::vector<Rotation> {
+        std::vector<Rotation> result;
+        let sides = metric == Metric::SLICE ? std::vector{FRONT, BACK, MIDDLE} : std::vector{FRONT, BACK};
+        for (let side : sides) {
+            for (dim_t axis = 0; axis < DIMS; ++axis) {
+                for (dim_t from = 0; from < DIMS; ++from) {
+                    for (dim_t to = 0; to < DIMS; ++to) {
+                        if (axis != from && from != to && to != axis) {
+                            result.push_back(Rotation{axis, from, to, side});
+                        }
+                    }
+                }
+            }
+        }
+        if (metric == Metric::HALF) {
+            let halves = half_turns<DIMS>();
+            result.insert(result.end(), halves.begin(), halves.end());
+        }
+        return result;
+    }
+
+    // the moves of every metric: the slice metric's, then the half turns. this is how moves
+    // are named outside a solver, as the metrics' own orders disagree past the face quarter turns.
+    template <dim_t DIMS>
+    static auto every() -> std::vector<Rotation> {
+        auto result = all<DIMS>(Metric::SLICE);
+        let halves = half_turns<DIMS>();
+        result.insert(result.end(), halves.begin(), halves.end());
+        return result;
+    }
+
+    template <dim_t DIMS>
+    static auto half_turns() -> std::vector<Rotation> {
+        std::vector<Rotation> result;
+        for (let side : {FRONT, BACK}) {
+            for (dim_t axis = 0; axis < DIMS; ++axis) {
+                for (dim_t from = 0; from < DIMS; ++from) {
+                    for (dim_t to = from + 1; to < DIMS; ++to) {
+                        if (axis != from && to != axis) {
+                            result.push_back(Rotation{axis, from, to, side, 2});
+                        }
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    // turning from `to` into `from` undoes turning from `from` into `to`.
+    auto inverse() const -> Rotation {
+        return turns == 2 ? *this : Rotation{axis, to, from, side};
+    }
+
+    auto operator==(const Rotation& other) const -> bool {
+        let same_way = from == other.from && to == other.to;
+        let either_way = turns == 2 && from == other.to && to == other.from;
+        return axis == other.axis && side == other.side && turns == other.turns && (same_way || either_way);
+    }
+
+    // how many quarter steps, in the direction from the lower axis to the higher, this turns its layer.
+    auto steps() const -> int {
+        return turns == 2 ? 2 : from < to ? 1 : 3;
+    }
+
+    // what this move counts for in the metric: moves the metric lacks count as the moves it
+    // would take instead, a slice as its two faces and a half turn as two quarters.
+    auto cost(Metric metric) const -> int {
+        return (side == MIDDLE && metric != Metric::SLICE ? 2 : 1) * (turns == 2 && metric != Metric::HALF ? 2 : 1);
+    }
+
+    // the four digits the interactive prompt reads back in, and a fifth, 2, for a half turn.
+    auto to_string() const -> std::string {
+        return std::to_string(axis) + std::to_string(from) + std::to_string(to) + std::to_string(side) +
+               (turns == 2 ? "2" : "");
+    }
+};
+
+inline auto solution_length(std::span<const Rotation> rotations, Metric metric) -> int {
+    return std::transform_reduce(rotations.begin(), rotations.end(), 0, std::plus{}, [&](let& r) {
+        return r.cost(metric);
+    });
+}
+
+inline auto format_rotations(std::span<const Rotation> rotations) -> std::string {
+    std::string out;
+    for (let& r : rotations) {
+        out += (out.empty() ? "" : ",") + r.to_string();
+    }
+    return out;
+}
+
+// the decisions of one seeded Cube::solve run, a bit per move tried that is set if the move
+// was kept. the seed alone reproduces the run; the bits let a replay check that it did.
+struct SolveTrace {
+    uint64_t seed = 0;
+    size_t steps = 0;
+    std::vector<uint64_t> kept;
+
+    void push(bool keep) {
+        if (steps % 64 == 0) {
+            kept.push_back(0);
+        }
+        kept.back() |= (uint64_t)keep << (steps % 64);
+        ++steps;
+    }
+
+    auto at(size_t step) const -> bool {
+        return (kept[step / 64] >> (step % 64)) & 1;
+    }
+};
+
+template <dim_t DIMS>
+struct Point {
+    using vec = std::array<coord_t, DIMS>;
+    vec original_coords = {0};
+    vec coords = {0};
+    vec orientation = {0};
+
+    static auto create(vec input) -> Point {
+        vec orientation;
+        std::iota(orientation.begin(), orientation.end(), 0);
+        return Point{input, input, orientation};
+    }
+
+    static auto index_of(const vec& c) -> uint32_t {
+        uint32_t idx = 0;
+        for (size_t index = DIMS; index-- > 0;) {
+            idx = idx * 3 + c[index];
+        }
+        return idx;
+    }
+
+    static auto from_index(size_t i) -> Point {
+        vec vals;
+        for (size_t index = 0; index < DIMS; ++index) {
+            let dividend = i / (ipow(3, index));
+            vals[index] = (dividend % 3);
+        }
+        return create(vals);
+    }
+
+    void rotate(const Rotation r) {
+        let rotation_axis = r.axis;
+        let from_axis = r.from;
+        let to_axis = r.to;
+
+        assert(rotation_axis != from_axis && from_axis != to_axis && to_axis != rotation_axis);
+        assert(rotation_axis < DIMS && from_axis < DIMS && to_axis < DIMS);
+
+        // is this point on the face that we're rotating?
+        if (coords[rotation_axis] != r.side) {
+            return;
+        }
+
+        // two swaps of the orientation cancel, and the coordinates are reflected.
+        if (r.turns == 2) {
+            coords[from_axis] = 2 - coords[from_axis];
+            coords[to_axis] = 2 - coords[to_axis];
+            return;
+        }
+
+        // this is trivial
+        std::swap(orientation[from_axis], orientation[to_axis]);
+
+        // this is not
+        switch (coords[from_axis]) {
+            case 0:
+                switch (coords[to_axis]) {
+                    case 0:
+                        coords[from_axis] = 2;
+                        coords[to_axis] = 0;
+                        break;
+                    case 1:
+                        coords[from_axis] = 1;
+                        coords[to_axis] = 0;
+                        break;
+                    case 2:
+                        coords[from_axis] = 0;
+                        coords[to_axis] = 0;
+                        break;
+                    default:
+                        assert(false);
+                }
+                break;
+            case 1:
+                switch (coords[to_axis]) {
+                    case 0:
+                        coords[from_axis] = 2;
+                        coords[to_axis] = 1;
+                        break;
+                    case 1:
+                        break;
+                    case 2:
+                        coords[from_axis] = 0;
+                        coords[to_axis] = 1;
+                        break;
+                    default:
+                        assert(false);
+                }
+                break;
+            case 2:
+                switch (coords[to_axis]) {
+                    case 0:
+                        coords[from_axis] = 2;
+                        coords[to_axis] = 2;
+                        break;
+                    case 1:
+                        coords[from_axis] = 1;
+                        coords[to_axis] = 2;
+                        break;
+                    case 2:
+                        coords[from_axis] = 0;
+                        coords[to_axis] = 2;
+                        break;
+                    default:
+                        assert(false);
+                }
+                break;
+            default:
+                assert(false);
+        }
+    }
+
+    auto index() const -> uint32_t {
+        return index_of(coords);
+    }
+
+    auto is_in_original_position() const -> bool {
+        return coords == original_coords;
+    }
+
+    auto is_in_original_orientation() const -> bool {
+        return std::is_sorted(orientation.begin(), orientation.end());
+    }
+
+    // face centres and the core, which no sticker shows the orientation of.
+    // only slice turns move centres, or turn the core.
+    auto is_center() const -> bool {
+        return std::count(coords.begin(), coords.end(), 1) >= DIMS - 1;
+    }
+
+    auto to_string() const -> std::string {
+        std::stringstream out;
+        out << RESET;
+        out << "Current coordinates: ";
+        if (is_in_original_position()) {
+            out << GREEN;
+        } else {
+            out << RED;
+        }
+        for (auto c : coords) out << (int)c << " ";
+        out << RESET;
+        out << "Orientation: ";
+        if (is_in_original_orientation()) {
+            out << GREEN;
+        } else {
+            out << RED;
+        }
+        for (auto c : orientation) out << (int)c << " ";
+        out << RESET;
+        out << "Original coordinates: ";
+        for (auto c : original_coords) out << (int)c << " ";
+        return out.str();
+    }
+
+    auto dist_from_original() const -> int {
+        return std::transform_reduce(
+            coords.begin(), coords.end(), 
+            original_coords.begin(),
+            0, std::plus{}, [](auto a, auto b) {
+                return std::abs(a - b);
+            });
+    }
+
+    auto incorrectness() const -> int {
+        auto smallmod = is_in_original_orientation() ? 0 : 1;
+        return dist_from_original() + smallmod * 10;
+    }
+
+    // admissible counterpart to incorrectness(): a move carries a point at most max_travel
+    // in manhattan distance, and a misorientation costs at least one turn.
+    auto lower_bound(Metric metric = Metric::QUARTER) const -> int {
+        let reach = max_travel(metric);
+        let travel = (dist_from_original() + reach - 1) / reach;
+        let reorient = (is_in_original_orientation() || is_center()) ? 0 : 1;
+        return std::max(travel, reorient);
+    }
+};
+
+// a fixed-size array on the heap, aligned to cache lines, for when std::array would be too big
+// for the stack. copies are deep; a moved-from one is empty until assigned to.
+template <class T, size_t N>
+class HeapArray {
+    struct alignas(64) Block {
+        std::array<T, N> items;
+    };
+    std::unique_ptr<Block> block = std::make_unique<Block>();
+
+public:
+    HeapArray() = default;
+    HeapArray(const HeapArray& other) : block(std::make_unique<Block>(*other.block)) {}
+    HeapArray(HeapArray&&) noexcept = default;
+    auto operator=(HeapArray&&) noexcept -> HeapArray& = default;
+
+    auto operator=(const HeapArray& other) -> HeapArray& {
+        if (!block) {
+            block = std::make_unique<Block>();
+        }
+        block->items = other.block->items;
+        return *this;
+    }
+
+    auto operator[](size_t i) -> T& { return block->items[i]; }
+    auto operator[](size_t i) const -> const T& { return block->items[i]; }
+    auto data() -> T* { return block->items.data(); }
+    auto data() const -> const T* { return block->items.data(); }
+    auto begin() { return block->items.begin(); }
+    auto begin() const { return block->items.cbegin(); }
+    auto end() { return block->items.end(); }
+    auto end() const { return block->items.cend(); }
+    constexpr static auto size() -> size_t { return N; }
+};
+
+// threads kept waiting for one job at a time, for work too short to pay for parallel_for's
+// thread startup, such as turning a single large cube. the caller works on the job too.
+class WorkerPool {
+    std::mutex serial;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::vector<std::thread> threads;
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    size_t count = 0;
+    size_t grain = 0;
+    std::atomic<size_t> next = 0;
+    size_t busy = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void work() {
+        loop {
+            let begin = next.fetch_add(grain, std::memory_order_relaxed);
+            if (begin >= count) {
+                return;
+            }
+            (*job)(begin, std::min(count, begin + grain));
+        }
+    }
+
+    void serve() {
+        uint64_t seen = 0;
+        loop {
+            {
+                std::unique_lock lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+            }
+            work();
+            std::lock_guard lock(mutex);
+            if (--busy == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+
+    WorkerPool() {
+        let helpers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        for (unsigned t = 0; t < helpers; ++t) {
+            threads.emplace_back([this] { serve(); });
+        }
+    }
+
+public:
+    static auto instance() -> WorkerPool& {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    // calls f on chunks of `grain` covering [0, count), and returns once they are all done.
+    void run(size_t count, size_t grain, const std::function<void(size_t, size_t)>& f) {
+        std::lock_guard one_job(serial);
+        {
+            std::lock_guard lock(mutex);
+            job = &f;
+            this->count = count;
+            this->grain = grain;
+            next = 0;
+            busy = threads.size();
+            ++generation;
+        }
+        wake.notify_all();
+        work();
+        std::unique_lock lock(mutex);
+        finished.wait(lock, [&] { return busy == 0; });
+    }
+};
+
+// from here on a cube's points go on the heap and each turn is shared out across the WorkerPool.
+// no solver tables are built this large, but the cube can still be turned.
+constexpr auto LARGE_DIMS = 9;
+
+template <dim_t DIMS>
+struct Cube {
+    constexpr static auto NUM_POINTS = ipow(3, DIMS);
+    constexpr static auto LARGE = DIMS >= LARGE_DIMS;
+    // enough points per chunk to outweigh handing it to another thread.
+    constexpr static size_t ROTATE_GRAIN = 8192;
+    constexpr static std::array AXES = cag::make_array<DIMS>([](auto i) { return (dim_t)i; });
+    using Points = std::conditional_t<LARGE, HeapArray<Point<DIMS>, NUM_POINTS>, std::array<Point<DIMS>, NUM_POINTS>>;
+    Points points;
+    // for a large cube, the piece in each slot, so that a turn visits only the slots of its
+    // layer. rotate() keeps it up to date; anything else that writes points calls reindex().
+    struct Unindexed {};
+    [[no_unique_address]] std::conditional_t<LARGE, HeapArray<uint32_t, NUM_POINTS>, Unindexed> slots;
+
+    Cube() {
+        for (size_t idx = 0; idx < NUM_POINTS; ++idx) {
+            points[idx] = Point<DIMS>::from_index(idx);
+        }
+        reindex();
+    }
+
+    void reindex() {
+        if constexpr (LARGE) {
+            for (uint32_t i = 0; i < NUM_POINTS; ++i) {
+                slots[points[i].index()] = i;
+            }
+        }
+    }
+
+    void rotate(Rotation r) {
+        if constexpr (LARGE) {
+            rotate_layer(r);
+        } else {
+            std::for_each(
+                points.begin(),
+                points.end(),
+                [this, r](auto& p) {
+                    p.rotate(r);
+                });
+        }
+    }
+
+    // the slots of r's layer come in 3x3 squares across the (from, to) plane, one for each value
+    // of the other coordinates. a quarter turn takes (f, t) to (2 - t, f), carrying a square's
+    // corners round one 4-cycle and its edges round another about a fixed centre, and a half
+    // turn takes two steps round the same cycles. squares share no slots, so chunks of them
+    // turn in place on the WorkerPool, touching only the layer's third of the points.
+    void rotate_layer(Rotation r) {
+        assert(r.axis != r.from && r.from != r.to && r.to != r.axis);
+        assert(r.axis < DIMS && r.from < DIMS && r.to < DIMS);
+        constexpr auto SQUARES = NUM_POINTS / 27;
+        constexpr auto OTHERS = DIMS - 3;
+        std::array<uint32_t, OTHERS> strides;
+        for (dim_t axis = 0, j = 0; axis < DIMS; ++axis) {
+            if (axis != r.axis && axis != r.from && axis != r.to) {
+                strides[j++] = ipow(3, axis);
+            }
+        }
+        let layer = (uint32_t)r.side * ipow(3, r.axis);
+        let pf = (uint32_t)ipow(3, r.from);
+        let pt = (uint32_t)ipow(3, r.to);
+        WorkerPool::instance().run(SQUARES, ROTATE_GRAIN / 9, [&](size_t begin, size_t end) {
+            std::array<uint8_t, OTHERS> digits;
+            auto base = layer;
+            for (size_t j = 0, k = begin; j < OTHERS; ++j, k /= 3) {
+                digits[j] = k % 3;
+                base += digits[j] * strides[j];
+            }
+            for (auto k = begin; k < end; ++k) {
+                turn_square(base, pf, pt, r);
+                // on to the next square, counting the other coordinates up like an odometer.
+                for (size_t j = 0; j < OTHERS; ++j) {
+                    if (++digits[j] < 3) {
+                        base += strides[j];
+                        break;
+                    }
+                    digits[j] = 0;
+                    base -= 2 * strides[j];
+                }
+            }
+        });
+    }
+
+    // pf and pt are 3^from and 3^to, how far apart slots are along the plane.
+    void turn_square(uint32_t base, uint32_t pf, uint32_t pt, Rotation r) {
+        // (f, t) of the corners and of the edges, in the order a quarter turn carries them.
+        constexpr std::array<std::array<std::pair<coord_t, coord_t>, 4>, 2> CYCLES = {{
+            {{{0, 0}, {2, 0}, {2, 2}, {0, 2}}},
+            {{{1, 0}, {2, 1}, {1, 2}, {0, 1}}},
+        }};
+        let quarter = r.turns == 1;
+        let steps = quarter ? 1 : 2;
+        for (let& cycle : CYCLES) {
+            std::array<uint32_t, 4> pieces;
+            for (size_t k = 0; k < 4; ++k) {
+                pieces[k] = slots[base + cycle[k].first * pf + cycle[k].second * pt];
+            }
+            for (size_t k = 0; k < 4; ++k) {
+                let [f, t] = cycle[(k + steps) % 4];
+                slots[base + f * pf + t * pt] = pieces[k];
+                auto& p = points[pieces[k]];
+                p.coords[r.from] = f;
+                p.coords[r.to] = t;
+                if (quarter) {
+                    std::swap(p.orientation[r.from], p.orientation[r.to]);
+                }
+            }
+        }
+        if (quarter) {
+            auto& centre = points[slots[base + pf + pt]];
+            std::swap(centre.orientation[r.from], centre.orientation[r.to]);
+        }
+    }
+
+    void rotate_n(Rotation r, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            rotate(r);
+        }
+    }
+
+    void undo_rotation(Rotation r) {
+        rotate(r.inverse());
+    }
+
+    auto is_solved() const -> bool {
+        return std::all_of(
+            points.begin(),
+            points.end(),
+            [](let p) {
+                return p.is_in_original_position() && (p.is_in_original_orientation() || p.is_center());
+            });
+    }
+
+    auto unsolvedness() const -> int {
+        return std::transform_reduce(
+            points.begin(), points.end(),
+            0, std::plus{}, [](let p) {
+                return p.incorrectness();
+            });
+    }
+
+    // piece p sits where piece q started exactly when, in the inverse, q sits where p started,
+    // turned the opposite way. out's points keep their original coordinates.
+    void invert_into(Cube& out) const {
+        for (let& p : points) {
+            auto& q = out.points[p.index()];
+            q.coords = p.original_coords;
+            for (dim_t i = 0; i < DIMS; ++i) {
+                q.orientation[p.orientation[i]] = i;
+            }
+        }
+        out.reindex();
+    }
+
+    auto inverse() const -> Cube {
+        Cube out;
+        invert_into(out);
+        return out;
+    }
+
+    auto lower_bound(Metric metric = Metric::QUARTER) const -> int {
+        // a turn moves one layer of 3^(DIMS-1) points, each of whose bounds drops by at most one.
+        constexpr auto FACE = ipow(3, DIMS - 1);
+        int worst = 0;
+        int64_t total = 0;
+        for (let& p : points) {
+            let b = p.lower_bound(metric);
+            worst = std::max(worst, b);
+            total += b;
+        }
+        return std::max(worst, (int)((total + FACE - 1) / FACE));
+    }
+
+    void show() const {
+        std::cout << "Current state: " << std::endl;
+        // a large cube has too many points to list.
+        if constexpr (LARGE) {
+            let placed = std::count_if(points.begin(), points.end(), [](let& p) { return p.is_in_original_position(); });
+            std::cout << placed << " of " << NUM_POINTS << " points in place" << std::endl;
+        } else {
+            for (auto p : points) {
+                std::cout << p.to_string() << std::endl;
+            }
+        }
+        std::cout << "Solved? " << (is_solved() ? "Yes" : "No") << std::endl;
+        std::cout << "Unsolvedness: " << unsolvedness() << std::endl;
+    }
+
+    void shuffle(size_t times) {
+        for (size_t i = 0; i < times; ++i) {
+            rotate(Rotation::random<DIMS>());
+        }
+    }
+    
+    auto solve(size_t max_iterations = SIZE_MAX, bool verbose = false) -> std::vector<Rotation> {
+        return anneal([](uint32_t n) { return (uint32_t)rand() % n; }, [](bool) {}, max_iterations, verbose);
+    }
+
+    // the same, drawing from seed instead of rand(), and recording each decision into trace.
+    auto solve_recorded(uint64_t seed, SolveTrace& trace, size_t max_iterations = SIZE_MAX) -> std::vector<Rotation> {
+        auto rng = SplitMix{seed};
+        trace = SolveTrace{seed, 0, {}};
+        return anneal([&](uint32_t n) { return rng.below(n); }, [&](bool keep) { trace.push(keep); }, max_iterations);
+    }
+
+    // repeats a recorded run, or gives nullopt if any decision comes out differently.
+    auto solve_replayed(const SolveTrace& trace) -> std::optional<std::vector<Rotation>> {
+        auto rng = SplitMix{trace.seed};
+        size_t step = 0;
+        auto same = true;
+        auto rotations = anneal(
+            [&](uint32_t n) { return rng.below(n); },
+            [&](bool keep) { same = same && trace.at(step++) == keep; },
+            trace.steps);
+        if (!same || step != trace.steps) {
+            return std::nullopt;
+        }
+        return rotations;
+    }
+
+private:
+    // draw(n) gives a number in [0, n), and decided(keep) hears whether each move tried was kept.
+    template <class Draw, class Decided>
+    auto anneal(Draw&& draw, Decided&& decided, size_t max_iterations, bool verbose = false) -> std::vector<Rotation> {
+        std::vector<Rotation> rotations;
+        for (size_t i = 0; i < max_iterations && !is_solved(); ++i) {
+            let last_unsolvedness = unsolvedness();
+            let r = Rotation::random<DIMS>(draw);
+            rotate(r);
+            rotations.push_back(r);
+            let random_value = draw(100);
+            let current_unsolvedness = unsolvedness();
+            let keep = current_unsolvedness > last_unsolvedness ? random_value >= 90 : random_value >= 10;
+            if (!keep) {
+                undo_rotation(r);
+                rotations.pop_back();
+            }
+            decided(keep);
+            if (verbose) {
+                std::cout << unsolvedness() << std::endl;
+            }
+        }
+        if (verbose && is_solved()) {
+            std::cout << "solved in " << rotations.size() << " rotations." << std::endl;
+        }
+        return rotations;
+    }
+};
+
+template <dim_t DIMS>
+struct MoveTable {
+    constexpr static auto NUM_POINTS = ipow(3, DIMS);
+    std::vector<Rotation> moves;
+    std::vector<uint16_t> inverses;
+    Metric metric = Metric::QUARTER;
+    // the point index each point index is carried to, one row of NUM_POINTS per move.
+    std::vector<uint32_t> targets;
+    // the same, as the 4-cycles of slots each move's quarter turn permutes (slot k goes to slot
+    // k + 1) and the slots it only turns in place. every move has as many of each. a half turn
+    // keeps its quarter turn's cycles and takes two steps along them.
+    std::vector<std::array<uint32_t, 4>> cycles;
+    std::vector<uint32_t> fixed;
+    size_t cycles_per_move = 0;
+    size_t fixed_per_move = 0;
+    // whether a move is worth making straight after another, one row per previous move. it
+    // isn't when the two turn the same layer in the same plane, so that together they are
+    // nothing or a single move of the metric.
+    std::vector<uint8_t> follows_table;
+
+    static auto build(Metric metric = Metric::QUARTER) -> std::unique_ptr<MoveTable> {
+        return build(Rotation::all<DIMS>(metric), metric);
+    }
+
+    static auto build(std::vector<Rotation> moves, Metric metric) -> std::unique_ptr<MoveTable> {
+        auto table = std::make_unique<MoveTable>();
+        table->moves = std::move(moves);
+        table->metric = metric;
+        for (let& r : table->moves) {
+            let inv = std::find(table->moves.begin(), table->moves.end(), r.inverse());
+            table->inverses.push_back((uint16_t)(inv - table->moves.begin()));
+        }
+        table->targets.resize(table->moves.size() * NUM_POINTS);
+        for (size_t m = 0; m < table->moves.size(); ++m) {
+            for (size_t idx = 0; idx < NUM_POINTS; ++idx) {
+                auto p = Point<DIMS>::from_index(idx);
+                p.rotate(table->moves[m]);
+                table->targets[m * NUM_POINTS + idx] = p.index();
+            }
+            let r = table->moves[m];
+            let quarter = Rotation{r.axis, r.from, r.to, r.side};
+            let step = [&](uint32_t idx) {
+                auto p = Point<DIMS>::from_index(idx);
+                p.rotate(quarter);
+                return p.index();
+            };
+            std::vector<bool> seen(NUM_POINTS, false);
+            for (uint32_t idx = 0; idx < NUM_POINTS; ++idx) {
+                if (seen[idx] || Point<DIMS>::from_index(idx).coords[r.axis] != r.side) {
+                    continue;
+                }
+                if (step(idx) == idx) {
+                    table->fixed.push_back(idx);
+                    continue;
+                }
+                std::array<uint32_t, 4> cycle;
+                for (auto k = 0, at = (int)idx; k < 4; ++k, at = step(at)) {
+                    cycle[k] = at;
+                    seen[at] = true;
+                }
+                table->cycles.push_back(cycle);
+            }
+        }
+        if (!table->moves.empty()) {
+            table->cycles_per_move = table->cycles.size() / table->moves.size();
+            table->fixed_per_move = table->fixed.size() / table->moves.size();
+        }
+        let n = table->moves.size();
+        table->follows_table.assign(n * n, 1);
+        for (size_t last = 0; last < n; ++last) {
+            for (size_t m = 0; m < n; ++m) {
+                let a = table->moves[last];
+                let b = table->moves[m];
+                if (a.axis != b.axis || a.side != b.side || std::minmax(a.from, a.to) != std::minmax(b.from, b.to)) {
+                    continue;
+                }
+                let steps = (a.steps() + b.steps()) % 4;
+                let lo = std::min(a.from, a.to);
+                let hi = std::max(a.from, a.to);
+                let single = steps == 2 ? Rotation{a.axis, lo, hi, a.side, 2}
+                                        : Rotation{a.axis, steps == 1 ? lo : hi, steps == 1 ? hi : lo, a.side};
+                let in_table = std::find(table->moves.begin(), table->moves.end(), single) != table->moves.end();
+                table->follows_table[last * n + m] = steps != 0 && !in_table;
+            }
+        }
+        return table;
+    }
+
+    auto follows(size_t last, size_t move) const -> bool {
+        return follows_table[last * moves.size() + move];
+    }
+
+    auto cycles_of(size_t move) const -> std::span<const std::array<uint32_t, 4>> {
+        return std::span(cycles).subspan(move * cycles_per_move, cycles_per_move);
+    }
+
+    auto fixed_of(size_t move) const -> std::span<const uint32_t> {
+        return std::span(fixed).subspan(move * fixed_per_move, fixed_per_move);
+    }
+
+    auto size() const -> size_t {
+        return moves.size();
+    }
+
+    auto id_of(Rotation r) const -> uint16_t {
+        return std::find(moves.begin(), moves.end(), r) - moves.begin();
+    }
+
+    auto target(size_t move, uint32_t idx) const -> uint32_t {
+        return targets[move * NUM_POINTS + idx];
+    }
+
+    auto bytes() const -> std::span<const std::byte> {
+        return std::as_bytes(std::span(targets));
+    }
+};
+
+// the canonical sequences of `length` moves of a table, numbered from 0 to count() - 1 in
+// lexicographic order of move index, so that ranges of numbers can be handed to threads or
+// processes in equal shares. a sequence is canonical when each move follows the one before
+// (MoveTable::follows), a quarter turn comes at most twice running and then only the one of it
+// and its inverse that comes first in the table, and in a run of moves on one axis, which
+// commute exactly when they turn different layers, the sides never decrease.
+template <dim_t DIMS>
+class SequenceIndex {
+    constexpr static size_t NONE = SIZE_MAX;
+    constexpr static size_t START = 0;
+    const MoveTable<DIMS>* table;
+    size_t length;
+    size_t states;
+    // for each length up to `length`, row by row, the canonical continuations of that length
+    // from each state: START, or 1 + 2 * move + (run - 1) after `run` (1 or 2) of `move` in a row.
+    std::vector<uint64_t> counts;
+
+    auto step(size_t state, size_t move) const -> size_t {
+        if (state == START) {
+            return 1 + 2 * move;
+        }
+        let last = (state - 1) / 2;
+        let run = (state - 1) % 2 + 1;
+        let& a = table->moves[last];
+        let& b = table->moves[move];
+        if (!table->follows(last, move)) {
+            return NONE;
+        }
+        // a quarter turn twice is its inverse twice, so only the first of the two in the table doubles.
+        if (move == last) {
+            return run == 1 && move < table->inverses[move] ? state + 1 : NONE;
+        }
+        return a.axis == b.axis && b.side < a.side ? NONE : 1 + 2 * move;
+    }
+
+    auto count_from(size_t remaining, size_t state) const -> uint64_t {
+        return counts[remaining * states + state];
+    }
+
+public:
+    SequenceIndex(const MoveTable<DIMS>& table, size_t length)
+        : table(&table), length(length), states(1 + 2 * table.size()), counts((length + 1) * states, 0) {
+        std::fill_n(counts.begin(), states, 1);
+        for (size_t k = 1; k <= length; ++k) {
+            for (size_t state = 0; state < states; ++state) {
+                uint64_t total = 0;
+                for (size_t move = 0; move < table.size(); ++move) {
+                    let next = step(state, move);
+                    if (next != NONE) {
+                        [[maybe_unused]] let overflow = __builtin_add_overflow(total, count_from(k - 1, next), &total);
+                        assert(!overflow);
+                    }
+                }
+                counts[k * states + state] = total;
+            }
+        }
+    }
+
+    auto count() const -> uint64_t {
+        return count_from(length, START);
+    }
+
+    // the sequence numbered `index`, as move indices into the table.
+    auto unrank(uint64_t index) const -> std::vector<uint16_t> {
+        assert(index < count());
+        std::vector<uint16_t> sequence;
+        auto state = START;
+        for (size_t k = length; k > 0; --k) {
+            for (size_t move = 0; move < table->size(); ++move) {
+                let next = step(state, move);
+                let here = next == NONE ? 0 : count_from(k - 1, next);
+                if (index < here) {
+                    sequence.push_back(move);
+                    state = next;
+                    break;
+                }
+                index -= here;
+            }
+        }
+        return sequence;
+    }
+
+    // the number of a canonical sequence, or nullopt if it isn't one.
+    auto rank(std::span<const uint16_t> sequence) const -> std::optional<uint64_t> {
+        if (sequence.size() != length) {
+            return std::nullopt;
+        }
+        uint64_t index = 0;
+        auto state = START;
+        for (size_t i = 0; i < length; ++i) {
+            for (size_t move = 0; move < sequence[i]; ++move) {
+                let next = step(state, move);
+                index += next == NONE ? 0 : count_from(length - i - 1, next);
+            }
+            state = step(state, sequence[i]);
+            if (state == NONE) {
+                return std::nullopt;
+            }
+        }
+        return index;
+    }
+
+    // the sequences numbered [begin, end), produced one at a time by stepping to the next
+    // canonical sequence in place, rather than unranking each.
+    class Range {
+        const SequenceIndex* index;
+        uint64_t at;
+        uint64_t stop;
+        std::vector<uint16_t> sequence;
+        // the state before each move of the sequence, and after the last.
+        std::vector<size_t> before;
+
+        // the first canonical continuation of the sequence from position i on.
+        void fill(size_t i) {
+            for (; i < sequence.size(); ++i) {
+                for (size_t move = 0;; ++move) {
+                    let next = index->step(before[i], move);
+                    if (next != NONE && index->count_from(sequence.size() - i - 1, next) > 0) {
+                        sequence[i] = move;
+                        before[i + 1] = next;
+                        break;
+                    }
+                }
+            }
+        }
+
+        void advance() {
+            for (auto i = sequence.size(); i-- > 0;) {
+                for (size_t move = sequence[i] + 1; move < index->table->size(); ++move) {
+                    let next = index->step(before[i], move);
+                    if (next != NONE && index->count_from(sequence.size() - i - 1, next) > 0) {
+                        sequence[i] = move;
+                        before[i + 1] = next;
+                        fill(i + 1);
+                        return;
+                    }
+                }
+            }
+        }
+
+    public:
+        Range(const SequenceIndex& index, uint64_t begin, uint64_t end)
+            : index(&index), at(begin), stop(std::min(end, index.count())), before(index.length + 1, START) {
+            if (at < stop) {
+                sequence = index.unrank(at);
+                for (size_t i = 0; i < sequence.size(); ++i) {
+                    before[i + 1] = index.step(before[i], sequence[i]);
+                }
+            }
+        }
+
+        struct End {};
+
+        class Iterator {
+            Range* range;
+
+        public:
+            explicit Iterator(Range* range) : range(range) {}
+            auto operator*() const -> std::span<const uint16_t> { return range->sequence; }
+            auto operator++() -> Iterator& {
+                if (++range->at < range->stop) {
+                    range->advance();
+                }
+                return *this;
+            }
+            auto operator!=(End) const -> bool { return range->at < range->stop; }
+        };
+
+        auto begin() -> Iterator { return Iterator(this); }
+        auto end() const -> End { return {}; }
+    };
+
+    auto range(uint64_t begin, uint64_t end) const -> Range {
+        return Range(*this, begin, end);
+    }
+
+    // the share of the numbers part `part` of `parts` should take.
+    auto share(size_t part, size_t parts) const -> std::pair<uint64_t, uint64_t> {
+        let at = [&](size_t p) { return (uint64_t)((unsigned __int128)count() * p / parts); };
+        return {at(part), at(part + 1)};
+    }
+};
+
+// a cube state indexed by slot rather than by piece: which piece sits at each position and how
+// it is turned, with the orientation packed four bits per axis. a move only touches the slots
+// of one face, through the move table's cycles, and two states compose in one pass.
+template <dim_t DIMS>
+struct Permutation {
+    static_assert(DIMS <= 16, "orientations are packed four bits per axis");
+    constexpr static auto NUM_POINTS = ipow(3, DIMS);
+    constexpr static uint64_t IDENTITY = [] {
+        uint64_t packed = 0;
+        for (uint64_t axis = 0; axis < DIMS; ++axis) {
+            packed |= axis << (4 * axis);
+        }
+        return packed;
+    }();
+    std::vector<uint32_t> piece;
+    std::vector<uint64_t> orientation;
+
+    static auto identity() -> Permutation {
+        Permutation p{std::vector<uint32_t>(NUM_POINTS), std::vector<uint64_t>(NUM_POINTS, IDENTITY)};
+        std::iota(p.piece.begin(), p.piece.end(), 0);
+        return p;
+    }
+
+    static auto pack(const typename Point<DIMS>::vec& orientation) -> uint64_t {
+        uint64_t packed = 0;
+        for (size_t axis = 0; axis < DIMS; ++axis) {
+            packed |= (uint64_t)orientation[axis] << (4 * axis);
+        }
+        return packed;
+    }
+
+    static auto from(const Cube<DIMS>& cube) -> Permutation {
+        auto p = identity();
+        for (uint32_t i = 0; i < NUM_POINTS; ++i) {
+            let& point = cube.points[i];
+            p.piece[point.index()] = i;
+            p.orientation[point.index()] = pack(point.orientation);
+        }
+        return p;
+    }
+
+    auto to_cube() const -> Cube<DIMS> {
+        Cube<DIMS> cube;
+        for (uint32_t s = 0; s < NUM_POINTS; ++s) {
+            auto& point = cube.points[piece[s]];
+            point.coords = Point<DIMS>::from_index(s).coords;
+            for (size_t axis = 0; axis < DIMS; ++axis) {
+                point.orientation[axis] = (orientation[s] >> (4 * axis)) & 15;
+            }
+        }
+        cube.reindex();
+        return cube;
+    }
+
+    static auto swapped(uint64_t packed, dim_t from, dim_t to) -> uint64_t {
+        let diff = ((packed >> (4 * from)) ^ (packed >> (4 * to))) & 15;
+        return packed ^ (diff << (4 * from)) ^ (diff << (4 * to));
+    }
+
+    void reset() {
+        std::iota(piece.begin(), piece.end(), 0);
+        std::fill(orientation.begin(), orientation.end(), IDENTITY);
+    }
+
+    void apply(const MoveTable<DIMS>& table, size_t move) {
+        let r = table.moves[move];
+        if (r.turns == 2) {
+            for (let& c : table.cycles_of(move)) {
+                std::swap(piece[c[0]], piece[c[2]]);
+                std::swap(piece[c[1]], piece[c[3]]);
+                std::swap(orientation[c[0]], orientation[c[2]]);
+                std::swap(orientation[c[1]], orientation[c[3]]);
+            }
+            return;
+        }
+        for (let& c : table.cycles_of(move)) {
+            let last_piece = piece[c[3]];
+            let last_orientation = orientation[c[3]];
+            for (size_t k = 3; k > 0; --k) {
+                piece[c[k]] = piece[c[k - 1]];
+                orientation[c[k]] = swapped(orientation[c[k - 1]], r.from, r.to);
+            }
+            piece[c[0]] = last_piece;
+            orientation[c[0]] = swapped(last_orientation, r.from, r.to);
+        }
+        for (let s : table.fixed_of(move)) {
+            orientation[s] = swapped(orientation[s], r.from, r.to);
+        }
+    }
+
+    // this state, then `then`: whatever `then` carries from slot q ends where it ends,
+    // turned first as here and then as `then` turns it.
+    void compose_into(const Permutation& then, Permutation& out) const {
+        for (size_t s = 0; s < NUM_POINTS; ++s) {
+            let q = then.piece[s];
+            let before = orientation[q];
+            let after = then.orientation[s];
+            uint64_t packed = 0;
+            for (size_t axis = 0; axis < DIMS; ++axis) {
+                packed |= ((before >> (4 * ((after >> (4 * axis)) & 15))) & 15) << (4 * axis);
+            }
+            out.piece[s] = piece[q];
+            out.orientation[s] = packed;
+        }
+    }
+
+    // solved in the sense of Cube::is_solved, so centres may be turned any way.
+    auto is_identity() const -> bool {
+        let& centre = centres();
+        auto ok = true;
+        for (size_t s = 0; s < NUM_POINTS; ++s) {
+            ok &= piece[s] == s && (orientation[s] == IDENTITY || centre[s]);
+        }
+        return ok;
+    }
+
+    static auto centres() -> const std::vector<uint8_t>& {
+        static let mask = [] {
+            std::vector<uint8_t> mask(NUM_POINTS);
+            for (size_t s = 0; s < NUM_POINTS; ++s) {
+                mask[s] = Point<DIMS>::from_index(s).is_center();
+            }
+            return mask;
+        }();
+        return mask;
+    }
+};
+
+// every distinct state two moves from solved, each compiled to a single table, so a search can
+// take two plies with one application. pairs that cancel, or that land on a state a single move
+// or an earlier pair already reaches (the second order of two commuting moves, say), are dropped.
+// left empty where the tables would not fit the budget.
+template <dim_t DIMS>
+struct CompoundTable {
+    constexpr static auto NUM_POINTS = ipow(3, DIMS);
+    constexpr static size_t BUDGET = size_t{1} << 22;
+    std::vector<std::pair<uint16_t, uint16_t>> pairs;
+    // pairs come grouped by first move, those starting with m at [begins[m], begins[m + 1]).
+    std::vector<uint32_t> begins;
+    // the point index each point index is carried to, and the axes its orientation is read
+    // from, packed as in Permutation. one row of NUM_POINTS per pair.
+    std::vector<uint32_t> targets;
+    std::vector<uint64_t> turns;
+    std::vector<typename Point<DIMS>::vec> coords;
+
+    static auto build(const MoveTable<DIMS>& table) -> std::unique_ptr<CompoundTable> {
+        auto compound = std::make_unique<CompoundTable>();
+        let n = table.size();
+        if (n * n * NUM_POINTS > BUDGET) {
+            return compound;
+        }
+        for (size_t idx = 0; idx < NUM_POINTS; ++idx) {
+            compound->coords.push_back(Point<DIMS>::from_index(idx).coords);
+        }
+        // starting from the identity, the piece at each slot is the point index it came from.
+        auto state = Permutation<DIMS>::identity();
+        std::set<std::pair<std::vector<uint32_t>, std::vector<uint64_t>>> seen{{state.piece, state.orientation}};
+        for (size_t m = 0; m < n; ++m) {
+            state.reset();
+            state.apply(table, m);
+            seen.emplace(state.piece, state.orientation);
+        }
+        for (uint16_t first = 0; first < n; ++first) {
+            compound->begins.push_back(compound->pairs.size());
+            for (uint16_t second = 0; second < n; ++second) {
+                state.reset();
+                state.apply(table, first);
+                state.apply(table, second);
+                if (!seen.emplace(state.piece, state.orientation).second) {
+                    continue;
+                }
+                compound->pairs.emplace_back(first, second);
+                let row = compound->targets.size();
+                compound->targets.resize(row + NUM_POINTS);
+                compound->turns.resize(row + NUM_POINTS);
+                for (uint32_t s = 0; s < NUM_POINTS; ++s) {
+                    compound->targets[row + state.piece[s]] = s;
+                    compound->turns[row + state.piece[s]] = state.orientation[s];
+                }
+            }
+        }
+        compound->begins.push_back(compound->pairs.size());
+        return compound;
+    }
+
+    void apply(Cube<DIMS>& cube, size_t pair) const {
+        let row = pair * NUM_POINTS;
+        for (auto& p : cube.points) {
+            let idx = p.index();
+            let target = targets[row + idx];
+            let turn = turns[row + idx];
+            if (target == idx && turn == Permutation<DIMS>::IDENTITY) {
+                continue;
+            }
+            p.coords = coords[target];
+            let before = p.orientation;
+            for (size_t axis = 0; axis < DIMS; ++axis) {
+                p.orientation[axis] = before[(turn >> (4 * axis)) & 15];
+            }
+        }
+    }
+
+    auto bytes() const -> std::span<const std::byte> {
+        return std::as_bytes(std::span(targets));
+    }
+};
+
+// built on first get(), so a binary that supports many DIMS only pays for the ones it touches.
+template <class T>
+class Lazy {
+    std::function<std::unique_ptr<T>()> build;
+    std::once_flag once;
+    std::unique_ptr<T> value;
+    std::atomic<const T*> published = nullptr;
+
+   public:
+    explicit Lazy(std::function<std::unique_ptr<T>()> build = [] { return T::build(); }) : build(std::move(build)) {}
+
+    auto get() -> const T& {
+        std::call_once(once, [this] {
+            value = build();
+            published.store(value.get(), std::memory_order_release);
+        });
+        return *value;
+    }
+
+    // never blocks: null until some thread has finished building the value.
+    auto try_get() const -> const T* {
+        return published.load(std::memory_order_acquire);
+    }
+};
+
+// ask the kernel to read ahead, then fault in every page, so first lookups don't stall.
+inline void prefault(std::span<const std::byte> bytes) {
+    if (bytes.empty()) {
+        return;
+    }
+    let page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    let start = (uintptr_t)bytes.data() & ~(page - 1);
+    let end = (uintptr_t)(bytes.data() + bytes.size());
+    madvise((void*)start, end - start, MADV_WILLNEED);
+    volatile std::byte sink{};
+    for (size_t i = 0; i < bytes.size(); i += page) {
+        sink = bytes[i];
+    }
+    (void)sink;
+}
+
+// splits [0, count) into chunks of `grain` and hands them out to every hardware thread.
+template <class F>
+void parallel_for(size_t count, size_t grain, F&& f) {
+    let threads = std::max(1u, std::thread::hardware_concurrency());
+    std::atomic<size_t> next = 0;
+    let work = [&] {
+        loop {
+            let begin = next.fetch_add(grain, std::memory_order_relaxed);
+            if (begin >= count) {
+                return;
+            }
+            f(begin, std::min(count, begin + grain));
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (auto& t : pool) {
+        t.join();
+    }
+}
+
+// distance-from-goal mod 3 in two bits per state, packed 32 to a word.
+// that is enough to recover exact distances, since neighbours differ by at most one.
+class DistanceTable {
+    size_t count;
+    std::unique_ptr<std::atomic<uint64_t>[]> owned;
+    std::atomic<uint64_t>* words;
+
+    DistanceTable(size_t count, std::atomic<uint64_t>* words) : count(count), words(words) {}
+
+   public:
+    constexpr static uint8_t UNSEEN = 3;
+    constexpr static size_t PER_WORD = 32;
+
+    explicit DistanceTable(size_t count)
+        : count(count), owned(new std::atomic<uint64_t>[num_words(count)]), words(owned.get()) {
+        for (size_t i = 0; i < num_words(count); ++i) {
+            words[i].store(~uint64_t{0}, std::memory_order_relaxed);
+        }
+    }
+
+    // a plain copy, for replicating a finished table; not safe against concurrent writers.
+    DistanceTable(const DistanceTable& other) : DistanceTable(other.count) {
+        for (size_t i = 0; i < num_words(count); ++i) {
+            words[i].store(other.words[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    DistanceTable(DistanceTable&&) = default;
+
+    // copies other into num_words(other.size()) words of caller-owned memory, such as a shared
+    // mapping, and returns a table that reads them without owning them.
+    static auto copy_into(const DistanceTable& other, std::atomic<uint64_t>* memory) -> DistanceTable {
+        for (size_t i = 0; i < num_words(other.count); ++i) {
+            new (&memory[i]) std::atomic<uint64_t>(other.words[i].load(std::memory_order_relaxed));
+        }
+        return DistanceTable(other.count, memory);
+    }
+
+    static auto num_words(size_t count) -> size_t {
+        return (count + PER_WORD - 1) / PER_WORD;
+    }
+
+    auto size() const -> size_t {
+        return count;
+    }
+
+    auto get(size_t i) const -> uint8_t {
+        return (words[i / PER_WORD].load(std::memory_order_relaxed) >> (2 * (i % PER_WORD))) & 3;
+    }
+
+    // only the first writer of an unseen state wins, however many threads race for it.
+    auto try_set(size_t i, uint8_t value) -> bool {
+        auto& word = words[i / PER_WORD];
+        let shift = 2 * (i % PER_WORD);
+        auto old = word.load(std::memory_order_relaxed);
+        while (((old >> shift) & 3) == UNSEEN) {
+            let desired = (old & ~(uint64_t{3} << shift)) | ((uint64_t)value << shift);
+            if (word.compare_exchange_weak(old, desired, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto bytes() const -> std::span<const std::byte> {
+        return {(const std::byte*)words, num_words(count) * sizeof(uint64_t)};
+    }
+};
+
+// layer-by-layer breadth-first search outward from space.goal(), spread over every thread.
+// a Space has size(), goal(), has_free_moves() and neighbours(rank, visit), where
+// visit(rank, cost) returns true to stop early and cost is 0 or 1 per move.
+// small layers are expanded forwards from the frontier; once the frontier outgrows the
+// unseen states, each unseen state instead looks backwards for a neighbour in the frontier.
+// free moves are closed over within a layer before the layer is stepped past.
+template <class Space>
+auto parallel_bfs(const Space& space) -> DistanceTable {
+    constexpr auto GRAIN = DistanceTable::PER_WORD * 64;
+    DistanceTable table(space.size());
+    table.try_set(space.goal(), 0);
+    size_t seen = 1;
+    size_t frontier = 1;
+    let expand = [&](uint8_t from, uint8_t to, uint8_t cost) {
+        let forwards = frontier < space.size() - seen;
+        std::atomic<size_t> found = 0;
+        parallel_for(space.size(), GRAIN, [&](size_t begin, size_t end) {
+            size_t local = 0;
+            for (auto i = begin; i < end; ++i) {
+                if (forwards && table.get(i) == from) {
+                    space.neighbours(i, [&](size_t nb, uint8_t c) {
+                        local += c == cost && table.try_set(nb, to);
+                        return false;
+                    });
+                } else if (!forwards && table.get(i) == DistanceTable::UNSEEN) {
+                    auto hit = false;
+                    space.neighbours(i, [&](size_t nb, uint8_t c) {
+                        return hit = c == cost && table.get(nb) == from;
+                    });
+                    local += hit && table.try_set(i, to);
+                }
+            }
+            found.fetch_add(local, std::memory_order_relaxed);
+        });
+        seen += found.load();
+        return found.load();
+    };
+    for (auto depth = 0; frontier > 0; ++depth) {
+        let current = (uint8_t)(depth % 3);
+        if (space.has_free_moves()) {
+            while (let added = expand(current, current, 0)) {
+                frontier += added;
+            }
+        }
+        frontier = expand(current, (depth + 1) % 3, 1);
+    }
+    return table;
+}
+
+constexpr auto factorial(int64_t n) -> int64_t {
+    return n < 2 ? 1 : n * factorial(n - 1);
+}
+
+// lehmer code of a permutation of 0..N-1, so the identity ranks 0.
+template <size_t N>
+auto perm_rank(const std::array<coord_t, N>& perm) -> uint32_t {
+    uint32_t rank = 0;
+    for (size_t i = 0; i < N; ++i) {
+        uint32_t smaller = 0;
+        for (auto j = i + 1; j < N; ++j) {
+            smaller += perm[j] < perm[i];
+        }
+        rank = rank * (N - i) + smaller;
+    }
+    return rank;
+}
+
+template <size_t N>
+auto perm_unrank(uint32_t rank) -> std::array<coord_t, N> {
+    std::array<coord_t, N> digits;
+    for (auto i = N; i-- > 0;) {
+        digits[i] = rank % (N - i);
+        rank /= (N - i);
+    }
+    std::array<coord_t, N> perm;
+    std::array<bool, N> used = {false};
+    for (size_t i = 0; i < N; ++i) {
+        coord_t v = 0;
+        for (auto skip = digits[i];; ++v) {
+            if (used[v]) {
+                continue;
+            }
+            if (skip == 0) {
+                break;
+            }
+            --skip;
+        }
+        used[v] = true;
+        perm[i] = v;
+    }
+    return perm;
+}
+
+// the pieces a pattern database tracks. pieces never leave their class - the positions
+// with the same number of coordinates equal to 1 - so positions are ranked within it.
+struct PatternSpec {
+    // 0 for corners, 1 for the edges next to them, and so on.
+    dim_t ones;
+    // indices into the class's positions, in ascending point-index order.
+    std::vector<uint32_t> pieces;
+    bool orientation = true;
+    // the rotation axes whose moves count towards this database's distances; the rest are free.
+    // empty means every move counts.
+    std::vector<dim_t> axes = {};
+};
+
+template <dim_t DIMS>
+struct PatternSpace {
+    constexpr static auto NUM_POINTS = ipow(3, DIMS);
+    constexpr static auto MAX_PIECES = 16;
+    constexpr static auto ORIENTATIONS = factorial(DIMS);
+    using State = std::array<uint32_t, MAX_PIECES * 2>;
+
+    PatternSpec spec;
+    std::vector<uint32_t> slots;
+    std::vector<int32_t> slot_of;
+    size_t num_moves = 0;
+    // per move, the slot each slot is carried to, and whether the turn touched it at all.
+    std::vector<uint32_t> next_slot;
+    std::vector<uint8_t> turned;
+    std::vector<std::pair<dim_t, dim_t>> swaps;
+    std::vector<uint8_t> costs;
+    // per orientation rank and (from, to) pair, the rank after that turn.
+    std::vector<uint32_t> next_orientation;
+    uint64_t orientations = 1;
+    uint64_t num_states = 1;
+    // false when there are more states than a u64 counts, and size() means nothing.
+    bool fits = true;
+
+    PatternSpace(const MoveTable<DIMS>& table, PatternSpec s) : spec(std::move(s)), slot_of(NUM_POINTS, -1) {
+        assert(spec.pieces.size() <= MAX_PIECES);
+        for (uint32_t idx = 0; idx < NUM_POINTS; ++idx) {
+            let p = Point<DIMS>::from_index(idx);
+            if (std::count(p.coords.begin(), p.coords.end(), 1) == spec.ones) {
+                slot_of[idx] = slots.size();
+                slots.push_back(idx);
+            }
+        }
+        num_moves = table.size();
+        for (size_t m = 0; m < num_moves; ++m) {
+            let r = table.moves[m];
+            // a half turn swaps twice, which is no swap at all.
+            swaps.emplace_back(r.from, r.turns == 2 ? r.from : r.to);
+            costs.push_back(spec.axes.empty() || std::find(spec.axes.begin(), spec.axes.end(), r.axis) != spec.axes.end());
+            for (let idx : slots) {
+                next_slot.push_back(slot_of[table.target(m, idx)]);
+                turned.push_back(Point<DIMS>::from_index(idx).coords[r.axis] == r.side);
+            }
+        }
+        if (spec.orientation) {
+            orientations = ORIENTATIONS;
+            next_orientation.resize(ORIENTATIONS * DIMS * DIMS);
+            for (uint32_t o = 0; o < ORIENTATIONS; ++o) {
+                for (dim_t from = 0; from < DIMS; ++from) {
+                    for (dim_t to = 0; to < DIMS; ++to) {
+                        auto perm = perm_unrank<DIMS>(o);
+                        std::swap(perm[from], perm[to]);
+                        next_orientation[(o * DIMS + from) * DIMS + to] = perm_rank(perm);
+                    }
+                }
+            }
+        }
+        for (size_t i = 0; i < spec.pieces.size(); ++i) {
+            fits = fits && !__builtin_mul_overflow(num_states, (slots.size() - i) * orientations, &num_states);
+        }
+    }
+
+    auto size() const -> size_t {
+        return num_states;
+    }
+
+    auto has_free_moves() const -> bool {
+        return std::find(costs.begin(), costs.end(), 0) != costs.end();
+    }
+
+    auto goal() const -> size_t {
+        State state;
+        for (size_t i = 0; i < spec.pieces.size(); ++i) {
+            state[2 * i] = spec.pieces[i];
+            state[2 * i + 1] = 0;
+        }
+        return rank(state);
+    }
+
+    // slots as a k-permutation of the class, then one orientation digit per piece.
+    auto rank(const State& state) const -> uint64_t {
+        let k = spec.pieces.size();
+        uint64_t r = 0;
+        for (size_t i = 0; i < k; ++i) {
+            auto idx = state[2 * i];
+            for (size_t j = 0; j < i; ++j) {
+                idx -= state[2 * j] < state[2 * i];
+            }
+            r = r * (slots.size() - i) + idx;
+        }
+        for (size_t i = 0; i < k; ++i) {
+            r = r * orientations + state[2 * i + 1];
+        }
+        return r;
+    }
+
+    auto unrank(uint64_t r) const -> State {
+        let k = spec.pieces.size();
+        State state;
+        for (auto i = k; i-- > 0;) {
+            state[2 * i + 1] = r % orientations;
+            r /= orientations;
+        }
+        for (auto i = k; i-- > 0;) {
+            state[2 * i] = r % (slots.size() - i);
+            r /= (slots.size() - i);
+        }
+        // turn "index among the slots still free" back into a slot.
+        for (size_t i = 0; i < k; ++i) {
+            std::array<uint32_t, MAX_PIECES> taken;
+            for (size_t j = 0; j < i; ++j) {
+                taken[j] = state[2 * j];
+            }
+            std::sort(taken.begin(), taken.begin() + i);
+            for (size_t j = 0; j < i; ++j) {
+                state[2 * i] += taken[j] <= state[2 * i];
+            }
+        }
+        return state;
+    }
+
+    auto apply(const State& state, size_t move) const -> State {
+        auto result = state;
+        let [from, to] = swaps[move];
+        for (size_t i = 0; i < spec.pieces.size(); ++i) {
+            let at = move * slots.size() + state[2 * i];
+            if (!turned[at]) {
+                continue;
+            }
+            result[2 * i] = next_slot[at];
+            if (spec.orientation) {
+                result[2 * i + 1] = next_orientation[(state[2 * i + 1] * DIMS + from) * DIMS + to];
+            }
+        }
+        return result;
+    }
+
+    template <class Visit>
+    void neighbours(uint64_t r, Visit&& visit) const {
+        let state = unrank(r);
+        for (size_t m = 0; m < num_moves; ++m) {
+            if (visit(rank(apply(state, m)), costs[m])) {
+                return;
+            }
+        }
+    }
+
+    auto project(const Cube<DIMS>& cube) const -> State {
+        State state;
+        for (size_t i = 0; i < spec.pieces.size(); ++i) {
+            let& p = cube.points[slots[spec.pieces[i]]];
+            state[2 * i] = slot_of[p.index()];
+            state[2 * i + 1] = spec.orientation ? perm_rank(p.orientation) : 0;
+        }
+        return state;
+    }
+};
+
+// the states of a plateau of free moves and a set of them, for PatternDb::distance to keep per
+// thread and clear rather than free, so that a lookup doesn't allocate once it has warmed up.
+struct Plateau {
+    constexpr static uint64_t EMPTY = UINT64_MAX;
+    std::vector<uint64_t> states;
+    // open addressing over a power of two, at most half full.
+    std::vector<uint64_t> seen = std::vector<uint64_t>(64, EMPTY);
+
+    auto home(uint64_t r) const -> size_t {
+        return (r * 0x9E3779B97F4A7C15ull) >> (64 - std::countr_zero(seen.size()));
+    }
+
+    auto place(uint64_t r) -> bool {
+        auto i = home(r);
+        for (; seen[i] != EMPTY; i = (i + 1) & (seen.size() - 1)) {
+            if (seen[i] == r) {
+                return false;
+            }
+        }
+        seen[i] = r;
+        return true;
+    }
+
+    void clear() {
+        if (states.size() * 8 > seen.size()) {
+            std::fill(seen.begin(), seen.end(), EMPTY);
+        } else {
+            // each state is somewhere along its probe chain, past any slots already cleared.
+            for (let r : states) {
+                auto i = home(r);
+                while (seen[i] != r) {
+                    i = (i + 1) & (seen.size() - 1);
+                }
+                seen[i] = EMPTY;
+            }
+        }
+        states.clear();
+    }
+
+    // adds r unless it is already here, and says whether it was added.
+    auto insert(uint64_t r) -> bool {
+        if ((states.size() + 1) * 2 > seen.size()) {
+            seen.assign(seen.size() * 2, EMPTY);
+            for (let s : states) {
+                place(s);
+            }
+        }
+        if (!place(r)) {
+            return false;
+        }
+        states.push_back(r);
+        return true;
+    }
+};
+
+template <dim_t DIMS>
+struct PatternDb {
+    PatternSpace<DIMS> space;
+    DistanceTable distances;
+
+    static auto build(const MoveTable<DIMS>& table, PatternSpec spec) -> PatternDb {
+        auto space = PatternSpace<DIMS>(table, std::move(spec));
+        assert(space.fits);
+        auto distances = parallel_bfs(space);
+        return PatternDb{std::move(space), std::move(distances)};
+    }
+
+    // walks downhill to the goal, one neighbour whose distance is one less at a time,
+    // searching across any plateau of free moves to find the way down.
+    // gives up at cap, which is then still a lower bound.
+    auto distance(uint64_t r, int cap = INT_MAX) const -> int {
+        static thread_local Plateau plateau;
+        for (auto d = 0;; ++d) {
+            if (d == cap) {
+                return cap;
+            }
+            let below = (uint8_t)((distances.get(r) + 2) % 3);
+            plateau.clear();
+            plateau.insert(r);
+            std::optional<uint64_t> down;
+            for (size_t i = 0; i < plateau.states.size() && !down; ++i) {
+                if (plateau.states[i] == space.goal()) {
+                    return d;
+                }
+                space.neighbours(plateau.states[i], [&](uint64_t nb, uint8_t cost) {
+                    if (cost == 1 && distances.get(nb) == below) {
+                        down = nb;
+                        return true;
+                    }
+                    if (cost == 0) {
+                        plateau.insert(nb);
+                    }
+                    return false;
+                });
+            }
+            assert(down);
+            r = *down;
+        }
+    }
+
+    auto rank(const Cube<DIMS>& cube) const -> uint64_t {
+        return space.rank(space.project(cube));
+    }
+
+    auto distance(const Cube<DIMS>& cube, int cap = INT_MAX) const -> int {
+        return distance(rank(cube), cap);
+    }
+};
+
+// which pattern databases to build and how to combine them, e.g.
+//     HeuristicSpec{.maxed = {{.ones = 0, .pieces = {0, 1, 2, 3}}, {.ones = 0, .pieces = {4, 5, 6, 7}}}}
+struct HeuristicSpec {
+    // summed. each move is charged to exactly one member through PatternSpec::axes,
+    // which keeps the sum admissible; members that leave axes empty share the rest round-robin.
+    // Heuristic::build maxes any member that would break this.
+    std::vector<PatternSpec> additive = {};
+    // maxed with each other and with the additive sum, so these may overlap freely.
+    std::vector<PatternSpec> maxed = {};
+};
+
+// for each piece class that moves, up to two pattern databases of the largest subset under budget states.
+// centres only move under slice turns, and then only their positions count.
+template <dim_t DIMS>
+auto default_heuristic(Metric metric = Metric::QUARTER, uint64_t budget = uint64_t{1} << 22) -> HeuristicSpec {
+    constexpr auto MAX_GROUPS = 2;
+    HeuristicSpec spec;
+    let classes = metric == Metric::SLICE ? DIMS : DIMS - 1;
+    for (dim_t ones = 0; ones < classes; ++ones) {
+        // C(DIMS, ones) choices of which coordinates are 1, and 2 sides for each of the others.
+        let members = factorial(DIMS) / factorial(ones) / factorial(DIMS - ones) * ipow(2, DIMS - ones);
+        let fits = [&](size_t size, uint64_t orientations) {
+            uint64_t states = 1;
+            for (size_t i = 0; i < size; ++i) {
+                states *= (members - i) * orientations;
+                if (states > budget) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        let orientation = ones + 1 < DIMS && fits(1, factorial(DIMS));
+        size_t size = 0;
+        while (size < (size_t)members && size < PatternSpace<DIMS>::MAX_PIECES &&
+               fits(size + 1, orientation ? factorial(DIMS) : 1)) {
+            ++size;
+        }
+        for (size_t group = 0; group < MAX_GROUPS && size > 0 && (group + 1) * size <= (size_t)members; ++group) {
+            PatternSpec pattern{ones, {}, orientation};
+            for (size_t i = 0; i < size; ++i) {
+                pattern.pieces.push_back(group * size + i);
+            }
+            spec.maxed.push_back(pattern);
+        }
+    }
+    return spec;
+}
+
+template <dim_t DIMS>
+struct Heuristic {
+    constexpr static auto MAX_DBS = 16;
+    // the exact distance each database gives the current state.
+    using Values = std::array<int, MAX_DBS>;
+    using States = std::array<typename PatternSpace<DIMS>::State, MAX_DBS>;
+    // the first num_additive are summed, the rest are maxed.
+    std::vector<PatternDb<DIMS>> dbs;
+    size_t num_additive = 0;
+
+    // a sum of members that charge the same move could overestimate, so an additive member
+    // that names an axis out of range or one already charged, or that is left with no axis to
+    // take, is maxed instead, counting every move, and a warning says so.
+    static auto build(const MoveTable<DIMS>& table, HeuristicSpec spec) -> std::unique_ptr<Heuristic> {
+        assert(spec.additive.size() + spec.maxed.size() <= MAX_DBS);
+        std::vector<bool> charged(DIMS, false);
+        std::vector<std::string> refused(spec.additive.size());
+        std::vector<size_t> unassigned;
+        for (size_t i = 0; i < spec.additive.size(); ++i) {
+            let& axes = spec.additive[i].axes;
+            if (axes.empty()) {
+                unassigned.push_back(i);
+            } else if (std::any_of(axes.begin(), axes.end(), [](auto axis) { return axis >= DIMS; })) {
+                refused[i] = "an axis out of range";
+            } else if (std::any_of(axes.begin(), axes.end(), [&](auto axis) {
+                           return charged[axis] || std::count(axes.begin(), axes.end(), axis) > 1;
+                       })) {
+                refused[i] = "an axis charged twice";
+            } else {
+                for (let axis : axes) {
+                    charged[axis] = true;
+                }
+            }
+        }
+        for (dim_t axis = 0, next = 0; axis < DIMS && !unassigned.empty(); ++axis) {
+            if (!charged[axis]) {
+                spec.additive[unassigned[next++ % unassigned.size()]].axes.push_back(axis);
+                charged[axis] = true;
+            }
+        }
+        for (let i : unassigned) {
+            if (spec.additive[i].axes.empty()) {
+                refused[i] = "no axis left to charge";
+            }
+        }
+        std::vector<PatternSpec> additive;
+        for (size_t i = 0; i < spec.additive.size(); ++i) {
+            if (refused[i].empty()) {
+                additive.push_back(std::move(spec.additive[i]));
+            } else {
+                std::cerr << "additive pattern " << i << " maxed instead: " << refused[i] << std::endl;
+                spec.additive[i].axes.clear();
+                spec.maxed.push_back(std::move(spec.additive[i]));
+            }
+        }
+        spec.additive = std::move(additive);
+
+        auto heuristic = std::make_unique<Heuristic>();
+        heuristic->num_additive = spec.additive.size();
+        for (auto& pattern : spec.additive) {
+            heuristic->dbs.push_back(PatternDb<DIMS>::build(table, std::move(pattern)));
+        }
+        for (auto& pattern : spec.maxed) {
+            heuristic->dbs.push_back(PatternDb<DIMS>::build(table, std::move(pattern)));
+        }
+        return heuristic;
+    }
+
+    auto evaluate(const Cube<DIMS>& cube) const -> Values {
+        Values values = {0};
+        for (size_t i = 0; i < dbs.size(); ++i) {
+            values[i] = dbs[i].distance(cube);
+        }
+        return values;
+    }
+
+    // exact values for a state one move on from `parent`, read off the mod 3 tables.
+    auto update(const Values& parent, const Cube<DIMS>& child) const -> Values {
+        Values values = {0};
+        for (size_t i = 0; i < dbs.size(); ++i) {
+            let now = dbs[i].distances.get(dbs[i].rank(child));
+            let before = parent[i] % 3;
+            values[i] = parent[i] + (now == before ? 0 : now == (before + 1) % 3 ? 1 : -1);
+        }
+        return values;
+    }
+
+    // the state in each pattern space, for stepping through moves without a cube.
+    auto project(const Cube<DIMS>& cube) const -> States {
+        States states;
+        for (size_t i = 0; i < dbs.size(); ++i) {
+            states[i] = dbs[i].space.project(cube);
+        }
+        return states;
+    }
+
+    // values and states one move on from `from`, read off the mod 3 tables as in update().
+    void advance(const Values& parent, const States& from, size_t move, Values& values, States& to) const {
+        for (size_t i = 0; i < dbs.size(); ++i) {
+            let& space = dbs[i].space;
+            to[i] = space.apply(from[i], move);
+            let now = dbs[i].distances.get(space.rank(to[i]));
+            let before = parent[i] % 3;
+            values[i] = parent[i] + (now == before ? 0 : now == (before + 1) % 3 ? 1 : -1);
+        }
+    }
+
+    // exact values for an unrelated state, such as the inverse of the one being searched,
+    // stopping each walk at cap since anything above it prunes all the same.
+    auto evaluate(const Cube<DIMS>& cube, int cap) const -> Values {
+        Values values = {0};
+        for (size_t i = 0; i < dbs.size(); ++i) {
+            values[i] = dbs[i].distance(cube, cap);
+        }
+        return values;
+    }
+
+    // `use` picks which databases take part, one bit each.
+    auto combine(const Values& values, uint32_t use = ~0u) const -> int {
+        auto sum = 0;
+        auto max = 0;
+        for (size_t i = 0; i < dbs.size(); ++i) {
+            let v = (use >> i) & 1 ? values[i] : 0;
+            sum += i < num_additive ? v : 0;
+            max = i < num_additive ? max : std::max(max, v);
+        }
+        return std::max(sum, max);
+    }
+
+    auto bytes() const -> std::vector<std::span<const std::byte>> {
+        std::vector<std::span<const std::byte>> result;
+        for (let& db : dbs) {
+            result.push_back(db.distances.bytes());
+        }
+        return result;
+    }
+};
+
+// one clause of a goal: the pieces whose home is in the given class and on the given face
+// (either may be left open) must be in place, turned the right way, or both.
+struct GoalTerm {
+    std::optional<dim_t> ones = std::nullopt;
+    std::optional<std::pair<dim_t, Side>> face = std::nullopt;
+    bool position = true;
+    bool orientation = true;
+};
+
+// a conjunction of GoalTerms, compiled to a mask and expected value over the bytes of
+// Cube::points, so checking a state is a masked compare of whole words.
+// centres are never asked to be turned the right way, as in Cube::is_solved.
+template <dim_t DIMS>
+struct Goal {
+    constexpr static auto NUM_POINTS = ipow(3, DIMS);
+    constexpr static auto BYTES = sizeof(std::array<Point<DIMS>, NUM_POINTS>);
+    constexpr static auto WORDS = (BYTES + 7) / 8;
+    std::array<uint64_t, WORDS> mask = {0};
+    std::array<uint64_t, WORDS> expected = {0};
+    std::vector<uint8_t> position = std::vector<uint8_t>(NUM_POINTS, 0);
+    std::vector<uint8_t> orientation = std::vector<uint8_t>(NUM_POINTS, 0);
+
+    static auto compile(std::span<const GoalTerm> terms) -> Goal {
+        static_assert(sizeof(Point<DIMS>) == 3 * DIMS, "points must pack without padding");
+        Goal goal;
+        std::array<uint8_t, WORDS * 8> mask_bytes = {0};
+        std::array<uint8_t, WORDS * 8> expected_bytes = {0};
+        for (uint32_t idx = 0; idx < NUM_POINTS; ++idx) {
+            let home = Point<DIMS>::from_index(idx);
+            for (let& term : terms) {
+                let ones = (dim_t)std::count(home.coords.begin(), home.coords.end(), 1);
+                if ((term.ones && *term.ones != ones) ||
+                    (term.face && home.coords[term.face->first] != term.face->second)) {
+                    continue;
+                }
+                goal.position[idx] |= term.position;
+                goal.orientation[idx] |= term.orientation && !home.is_center();
+            }
+            let at = idx * sizeof(Point<DIMS>);
+            for (size_t axis = 0; axis < DIMS; ++axis) {
+                if (goal.position[idx]) {
+                    mask_bytes[at + DIMS + axis] = 0xff;
+                    expected_bytes[at + DIMS + axis] = home.coords[axis];
+                }
+                if (goal.orientation[idx]) {
+                    mask_bytes[at + 2 * DIMS + axis] = 0xff;
+                    expected_bytes[at + 2 * DIMS + axis] = home.orientation[axis];
+                }
+            }
+        }
+        std::memcpy(goal.mask.data(), mask_bytes.data(), WORDS * 8);
+        std::memcpy(goal.expected.data(), expected_bytes.data(), WORDS * 8);
+        return goal;
+    }
+
+    static auto solved() -> Goal {
+        return compile(std::array{GoalTerm{}});
+    }
+
+    static auto placed(dim_t ones) -> Goal {
+        return compile(std::array{GoalTerm{.ones = ones, .orientation = false}});
+    }
+
+    static auto oriented() -> Goal {
+        return compile(std::array{GoalTerm{.position = false}});
+    }
+
+    static auto face_solved(dim_t axis, Side side) -> Goal {
+        return compile(std::array{GoalTerm{.face = std::pair{axis, side}}});
+    }
+
+    auto holds(const Cube<DIMS>& cube) const -> bool {
+        let bytes = (const std::byte*)cube.points.data();
+        uint64_t diff = 0;
+        for (size_t w = 0; w + 1 < WORDS; ++w) {
+            uint64_t word;
+            std::memcpy(&word, bytes + 8 * w, 8);
+            diff |= (word & mask[w]) ^ expected[w];
+        }
+        uint64_t tail = 0;
+        std::memcpy(&tail, bytes + 8 * (WORDS - 1), BYTES - 8 * (WORDS - 1));
+        diff |= (tail & mask[WORDS - 1]) ^ expected[WORDS - 1];
+        return diff == 0;
+    }
+
+    // the parts of the state the goal looks at, hashed, so states it can't tell apart hash alike.
+    auto hash(const Cube<DIMS>& cube) const -> uint64_t {
+        let bytes = (const std::byte*)cube.points.data();
+        uint64_t h = 0;
+        for (size_t w = 0; w < WORDS; ++w) {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes + 8 * w, std::min<size_t>(8, BYTES - 8 * w));
+            h = (h ^ (word & mask[w])) * 0x9e3779b97f4a7c15;
+            h ^= h >> 29;
+        }
+        return h;
+    }
+
+    // Cube::lower_bound over just the parts of each piece the goal asks about.
+    auto lower_bound(const Cube<DIMS>& cube, Metric metric = Metric::QUARTER) const -> int {
+        constexpr auto FACE = ipow(3, DIMS - 1);
+        let reach = max_travel(metric);
+        int worst = 0;
+        int64_t total = 0;
+        for (size_t idx = 0; idx < NUM_POINTS; ++idx) {
+            let& p = cube.points[idx];
+            let travel = position[idx] ? (p.dist_from_original() + reach - 1) / reach : 0;
+            let reorient = orientation[idx] && !p.is_in_original_orientation() ? 1 : 0;
+            let b = std::max(travel, reorient);
+            worst = std::max(worst, b);
+            total += b;
+        }
+        return std::max(worst, (int)((total + FACE - 1) / FACE));
+    }
+
+    // a pattern database stays admissible only if the goal asks for everything it tracks.
+    auto covers(const PatternDb<DIMS>& db) const -> bool {
+        let& space = db.space;
+        return std::all_of(space.spec.pieces.begin(), space.spec.pieces.end(), [&](auto piece) {
+            let idx = space.slots[piece];
+            return position[idx] && (!space.spec.orientation || orientation[idx]);
+        });
+    }
+};
+
+// an approximate set of state hashes, such as Goal::hash gives, for visited sets too big to hold
+// exactly. it can say a state was seen when it wasn't, at about the rate it was sized for, but
+// never the other way round. each key sets `hashes` bits in one 64-byte block, so a lookup is a
+// single cache line, compared against the key's masks as one vector. inserts set bits
+// atomically, so threads can share one as they insert; contains reads the block plainly and
+// wants no inserts running alongside it.
+class BloomFilter {
+    constexpr static size_t WORDS = 16;
+    constexpr static size_t BLOCK_BITS = 32 * WORDS;
+    // a block as one vector: 32-bit lanes, since sse2 compares no wider.
+    using Lanes = uint32_t __attribute__((vector_size(4 * WORDS)));
+
+    struct alignas(64) Block {
+        std::array<uint32_t, WORDS> words;
+    };
+
+    size_t num_blocks;
+    int hashes;
+    std::unique_ptr<Block[]> blocks;
+
+    auto block_of(uint64_t hash) const -> Block& {
+        return blocks[(size_t)(((unsigned __int128)hash * num_blocks) >> 64)];
+    }
+
+    // each position lands in every lane whose index matches its word, so there is no branch
+    // on, or store to, a word picked at run time.
+    void masks_of(uint64_t hash, Lanes& masks) const {
+        constexpr Lanes LANE = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+        masks = Lanes{};
+        // nine bits a position, from a stream remixed from the key so that positions are
+        // independent of each other and of the block. double hashing would reach too few patterns.
+        auto stream = SplitMix{hash};
+        uint64_t bits = 0;
+        for (auto i = 0; i < hashes; ++i, bits >>= 9) {
+            if (i % 7 == 0) {
+                bits = stream.next();
+            }
+            let in_block = bits % BLOCK_BITS;
+            masks |= (Lanes)(LANE == (uint32_t)(in_block / 32)) & (uint32_t{1} << (in_block % 32));
+        }
+    }
+
+public:
+    BloomFilter(size_t bytes, int hashes)
+        : num_blocks(std::max<size_t>(1, bytes / sizeof(Block))), hashes(hashes), blocks(new Block[num_blocks]) {
+        assert(hashes > 0);
+        clear();
+    }
+
+    // blocks fill unevenly, so the rate is averaged over how many keys land in each, a poisson
+    // count, and comes out above that of an unblocked filter of the same size.
+    static auto blocked_rate(uint64_t items, size_t num_blocks, int hashes) -> double {
+        let load = (double)items / num_blocks;
+        let last = (size_t)(load + 10 * std::sqrt(load) + 10);
+        auto chance = std::exp(-load);
+        auto rate = 0.0;
+        for (size_t keys = 0; keys <= last; ++keys) {
+            rate += chance * std::pow(1 - std::pow(1 - 1.0 / BLOCK_BITS, (double)hashes * keys), hashes);
+            chance *= load / (keys + 1);
+        }
+        return rate;
+    }
+
+    // about the fewest bytes, with the hashes to match, that keep false positives under `rate`
+    // for up to `items` keys.
+    static auto sized_for(uint64_t items, double rate) -> BloomFilter {
+        assert(rate > 0 && rate < 1);
+        let ln2 = std::log(2.0);
+        items = std::max<uint64_t>(items, 1);
+        // start from the size an unblocked filter needs, and grow until blocking is paid for.
+        auto bits = -(double)items * std::log(rate) / (ln2 * ln2);
+        loop {
+            let num_blocks = std::max<size_t>(1, (size_t)std::ceil(bits / BLOCK_BITS));
+            let hashes = std::clamp((int)std::round(bits / items * ln2), 1, 16);
+            if (blocked_rate(items, num_blocks, hashes) <= rate) {
+                return BloomFilter(num_blocks * sizeof(Block), hashes);
+            }
+            bits *= 1.05;
+        }
+    }
+
+    auto contains(uint64_t hash) const -> bool {
+        Lanes masks;
+        masks_of(hash, masks);
+        Lanes words;
+        std::memcpy(&words, block_of(hash).words.data(), sizeof(words));
+        let missing = masks & ~words;
+        uint32_t any = 0;
+        for (size_t w = 0; w < WORDS; ++w) {
+            any |= missing[w];
+        }
+        return any == 0;
+    }
+
+    // true if the key was new, as far as the filter can tell.
+    auto insert(uint64_t hash) -> bool {
+        Lanes masks;
+        masks_of(hash, masks);
+        auto& block = block_of(hash);
+        uint32_t missing = 0;
+        for (size_t w = 0; w < WORDS; ++w) {
+            if (masks[w]) {
+                missing |= ~std::atomic_ref(block.words[w]).fetch_or(masks[w], std::memory_order_relaxed) & masks[w];
+            }
+        }
+        return missing != 0;
+    }
+
+    void clear() {
+        for (size_t b = 0; b < num_blocks; ++b) {
+            blocks[b].words.fill(0);
+        }
+    }
+
+    // the false positive rate to expect after `items` keys.
+    auto expected_rate(uint64_t items) const -> double {
+        return blocked_rate(items, num_blocks, hashes);
+    }
+
+    auto bytes() const -> size_t {
+        return num_blocks * sizeof(Block);
+    }
+};
+
+// every state within `depth` moves of solved, with its exact distance and the move that starts
+// a shortest way home, in an open-addressed table keyed by Goal::solved().hash. depth is as deep
+// as fits the budget. the key alone can collide, so a completion is only trusted once walking
+// it reaches solved; a key that is absent, though, proves the state is further than depth.
+template <dim_t DIMS>
+struct EndgameTable {
+    constexpr static size_t BUDGET = size_t{1} << 24;
+    constexpr static uint64_t EMPTY = 0;
+
+    struct Entry {
+        uint64_t key;
+        uint16_t move;
+        uint8_t distance;
+    };
+
+    Goal<DIMS> goal = Goal<DIMS>::solved();
+    std::vector<Entry> entries;
+    int depth = -1;
+    size_t count = 0;
+
+    static auto build(const MoveTable<DIMS>& table, size_t budget = BUDGET) -> std::unique_ptr<EndgameTable> {
+        auto endgame = std::make_unique<EndgameTable>();
+        // kept at most half full, so probes stay short.
+        let capacity = std::bit_floor(std::max<size_t>(budget / sizeof(Entry), 2));
+        let limit = capacity / 2;
+        endgame->entries.assign(capacity, Entry{EMPTY, 0, 0});
+        auto cube = Cube<DIMS>();
+        endgame->insert(cube, 0, 0);
+        // deepen one layer at a time, so each state is first seen at its distance. a layer that
+        // won't fit if it grows like the last one isn't tried, and one that overflows anyway
+        // is taken back out.
+        size_t previous = 1;
+        auto growth = (double)table.size();
+        for (auto d = 1; d <= UINT8_MAX && table.size() > 1; ++d) {
+            let before = endgame->count;
+            if (before + previous * growth > limit) {
+                break;
+            }
+            if (!endgame->fill(table, cube, 0, d, NO_MOVE, limit)) {
+                endgame->drop(d);
+                break;
+            }
+            endgame->depth = d;
+            growth = (double)(endgame->count - before) / previous;
+            previous = endgame->count - before;
+        }
+        endgame->depth = std::max(endgame->depth, 0);
+        return endgame;
+    }
+
+    auto find(const Cube<DIMS>& cube) const -> const Entry* {
+        let key = goal.hash(cube) | 1;
+        let mask = entries.size() - 1;
+        for (auto at = key & mask;; at = (at + 1) & mask) {
+            if (entries[at].key == key) {
+                return &entries[at];
+            }
+            if (entries[at].key == EMPTY) {
+                return nullptr;
+            }
+        }
+    }
+
+    // the moves that take cube to solved, if the table has it.
+    auto complete(const Cube<DIMS>& cube, const MoveTable<DIMS>& table) const -> std::optional<std::vector<uint16_t>> {
+        auto scratch = cube;
+        std::vector<uint16_t> moves;
+        for (auto e = find(scratch); e; e = find(scratch)) {
+            if (e->distance == 0) {
+                return scratch.is_solved() ? std::optional(moves) : std::nullopt;
+            }
+            if (moves.size() >= (size_t)depth) {
+                break;
+            }
+            scratch.rotate(table.moves[e->move]);
+            moves.push_back(e->move);
+        }
+        return std::nullopt;
+    }
+
+    auto bytes() const -> std::span<const std::byte> {
+        return std::as_bytes(std::span(entries));
+    }
+
+   private:
+    constexpr static uint16_t NO_MOVE = UINT16_MAX;
+
+    void insert(const Cube<DIMS>& cube, uint16_t move, uint8_t distance) {
+        let key = goal.hash(cube) | 1;
+        let mask = entries.size() - 1;
+        auto at = key & mask;
+        while (entries[at].key != EMPTY && entries[at].key != key) {
+            at = (at + 1) & mask;
+        }
+        if (entries[at].key == EMPTY) {
+            entries[at] = Entry{key, move, distance};
+            ++count;
+        }
+    }
+
+    // adds every state d moves from solved, following only shortest paths to the states
+    // between. false once the table holds more than limit states.
+    auto fill(const MoveTable<DIMS>& table, Cube<DIMS>& cube, int g, int d, uint16_t last, size_t limit) -> bool {
+        for (uint16_t m = 0; m < table.size(); ++m) {
+            if (last != NO_MOVE && !table.follows(last, m)) {
+                continue;
+            }
+            cube.rotate(table.moves[m]);
+            auto ok = true;
+            if (g + 1 == d) {
+                insert(cube, table.inverses[m], (uint8_t)d);
+                ok = count <= limit;
+            } else if (let e = find(cube); e && e->distance == g + 1) {
+                ok = fill(table, cube, g + 1, d, m, limit);
+            }
+            cube.rotate(table.moves[table.inverses[m]]);
+            if (!ok) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // rehashes without the states at distance d.
+    void drop(int d) {
+        auto kept = std::vector<Entry>(entries.size(), Entry{EMPTY, 0, 0});
+        let mask = entries.size() - 1;
+        count = 0;
+        for (let& e : entries) {
+            if (e.key == EMPTY || e.distance >= d) {
+                continue;
+            }
+            auto at = e.key & mask;
+            while (kept[at].key != EMPTY) {
+                at = (at + 1) & mask;
+            }
+            kept[at] = e;
+            ++count;
+        }
+        entries = std::move(kept);
+    }
+};
+
+template <dim_t DIMS>
+struct Tables {
+    Metric metric;
+    Lazy<MoveTable<DIMS>> moves{[this] { return MoveTable<DIMS>::build(metric); }};
+    Lazy<Heuristic<DIMS>> heuristic{[this] { return Heuristic<DIMS>::build(moves.get(), default_heuristic<DIMS>(metric)); }};
+    Lazy<CompoundTable<DIMS>> compound{[this] { return CompoundTable<DIMS>::build(moves.get()); }};
+    Lazy<EndgameTable<DIMS>> endgame{[this] { return EndgameTable<DIMS>::build(moves.get()); }};
+
+    explicit Tables(Metric metric) : metric(metric) {}
+
+    // function-local statics, so nothing exists for a DIMS and metric until it is first asked for.
+    static auto instance(Metric metric = Metric::QUARTER) -> Tables& {
+        switch (metric) {
+            case Metric::SLICE: {
+                static Tables slice(Metric::SLICE);
+                return slice;
+            }
+            case Metric::HALF: {
+                static Tables half(Metric::HALF);
+                return half;
+            }
+            default: {
+                static Tables quarter(Metric::QUARTER);
+                return quarter;
+            }
+        }
+    }
+
+    auto ready() const -> bool {
+        return moves.try_get() != nullptr && heuristic.try_get() != nullptr;
+    }
+
+    void warm() {
+        prefault(moves.get().bytes());
+        for (let bytes : heuristic.get().bytes()) {
+            prefault(bytes);
+        }
+        prefault(compound.get().bytes());
+        prefault(endgame.get().bytes());
+    }
+};
+
+// every move of every metric, numbered as Rotation::every() does, for naming moves outside a solver.
+template <dim_t DIMS>
+auto every_move() -> const MoveTable<DIMS>& {
+    static Lazy<MoveTable<DIMS>> table{[] { return MoveTable<DIMS>::build(Rotation::every<DIMS>(), Metric::SLICE); }};
+    return table.get();
+}
+
+// how many states lie at each distance from solved, up to max_depth or until max_states have
+// been found, by breadth-first search with `seen` as the visited set. a state is kept as its
+// parent and the move from there, six bytes or so, and rebuilt from solved when its layer is
+// expanded, so the layers are only as big as their counts; seen is what runs out first, and a
+// false positive in it drops a state, so counts can come out a little low.
+template <dim_t DIMS>
+auto count_layers(int max_depth, uint64_t max_states, BloomFilter& seen, Metric metric = Metric::QUARTER)
+    -> std::vector<uint64_t> {
+    struct Step {
+        uint32_t parent;
+        uint16_t move;
+    };
+    let& table = Tables<DIMS>::instance(metric).moves.get();
+    let goal = Goal<DIMS>::solved();
+    seen.insert(goal.hash(Cube<DIMS>{}));
+    std::vector<std::vector<Step>> layers = {{Step{0, 0}}};
+    std::vector<uint64_t> counts = {1};
+    uint64_t total = 1;
+    while ((int)layers.size() <= max_depth && !layers.back().empty() && total < max_states) {
+        let depth = layers.size();
+        std::vector<Step> next;
+        std::mutex lock;
+        parallel_for(layers.back().size(), 256, [&](size_t begin, size_t end) {
+            std::vector<Step> found;
+            std::vector<uint16_t> path(depth - 1);
+            for (auto i = begin; i < end; ++i) {
+                auto at = i;
+                for (auto k = depth - 1; k > 0; --k) {
+                    path[k - 1] = layers[k][at].move;
+                    at = layers[k][at].parent;
+                }
+                Cube<DIMS> cube;
+                for (let move : path) {
+                    cube.rotate(table.moves[move]);
+                }
+                let last = path.empty() ? table.size() : path.back();
+                for (size_t move = 0; move < table.size(); ++move) {
+                    if (last < table.size() && !table.follows(last, move)) {
+                        continue;
+                    }
+                    cube.rotate(table.moves[move]);
+                    if (seen.insert(goal.hash(cube))) {
+                        found.push_back(Step{(uint32_t)i, (uint16_t)move});
+                    }
+                    cube.undo_rotation(table.moves[move]);
+                }
+            }
+            std::lock_guard guard(lock);
+            next.insert(next.end(), found.begin(), found.end());
+        });
+        counts.push_back(next.size());
+        total += next.size();
+        layers.push_back(std::move(next));
+    }
+    if (layers.back().empty()) {
+        counts.pop_back();
+    }
+    return counts;
+}
+
+// every intermediate state of a run of moves, in little more than the moves themselves: the
+// moves as every_move() ids, and a keyframe of each piece's coordinates and orientation every
+// `interval` moves. state k is rebuilt from the keyframe at or before it.
+template <dim_t DIMS>
+class Trajectory {
+    constexpr static auto NUM_POINTS = ipow(3, DIMS);
+    // coords then orientation, DIMS bytes each, per piece.
+    constexpr static auto KEYFRAME = NUM_POINTS * 2 * DIMS;
+
+    size_t interval;
+    std::vector<uint16_t> ids;
+    std::vector<coord_t> keyframes;
+    Cube<DIMS> last;
+
+    // ids by (axis, from, to, side, turns), rather than searching Rotation::every() per move.
+    // a half turn is the same move either way round, so it is keyed by its lower axis first.
+    static auto key(Rotation r) -> size_t {
+        if (r.turns == 2 && r.from > r.to) {
+            std::swap(r.from, r.to);
+        }
+        return (((r.axis * DIMS + r.from) * DIMS + r.to) * 3 + r.side) * 2 + r.turns - 1;
+    }
+
+    static auto lookup() -> const std::vector<uint16_t>& {
+        static let table = [] {
+            std::vector<uint16_t> ids(DIMS * DIMS * DIMS * 3 * 2, UINT16_MAX);
+            let all = Rotation::every<DIMS>();
+            for (size_t i = 0; i < all.size(); ++i) {
+                ids[key(all[i])] = i;
+            }
+            return ids;
+        }();
+        return table;
+    }
+
+    static auto moves_by_id() -> const std::vector<Rotation>& {
+        static let all = Rotation::every<DIMS>();
+        return all;
+    }
+
+    void keep(const Cube<DIMS>& cube) {
+        for (let& p : cube.points) {
+            keyframes.insert(keyframes.end(), p.coords.begin(), p.coords.end());
+            keyframes.insert(keyframes.end(), p.orientation.begin(), p.orientation.end());
+        }
+    }
+
+public:
+    // a keyframe costs about as many bytes as `interval` moves, so they take about half the space.
+    constexpr static size_t DEFAULT_INTERVAL = std::max<size_t>(64, KEYFRAME / 2);
+
+    explicit Trajectory(const Cube<DIMS>& start, size_t interval = DEFAULT_INTERVAL) : interval(interval), last(start) {
+        assert(interval > 0);
+        keep(start);
+    }
+
+    void push(Rotation r) {
+        let id = lookup()[key(r)];
+        assert(id != UINT16_MAX);
+        ids.push_back(id);
+        last.rotate(r);
+        if (ids.size() % interval == 0) {
+            keep(last);
+        }
+    }
+
+    // takes back the last move, and the keyframe of the state it led to.
+    void pop() {
+        assert(!ids.empty());
+        if (ids.size() % interval == 0) {
+            keyframes.resize(keyframes.size() - KEYFRAME);
+        }
+        last.undo_rotation(move(ids.size() - 1));
+        ids.pop_back();
+    }
+
+    // the number of states, one more than the number of moves.
+    auto size() const -> size_t {
+        return ids.size() + 1;
+    }
+
+    auto moves() const -> std::span<const uint16_t> {
+        return ids;
+    }
+
+    auto move(size_t k) const -> Rotation {
+        return moves_by_id()[ids[k]];
+    }
+
+    auto back() const -> const Cube<DIMS>& {
+        return last;
+    }
+
+    // the state after the first `step` moves.
+    auto at(size_t step) const -> Cube<DIMS> {
+        assert(step < size());
+        if (step + 1 == size()) {
+            return last;
+        }
+        let frame = step / interval;
+        Cube<DIMS> cube;
+        let* bytes = keyframes.data() + frame * KEYFRAME;
+        for (auto& p : cube.points) {
+            std::copy_n(bytes, DIMS, p.coords.begin());
+            std::copy_n(bytes + DIMS, DIMS, p.orientation.begin());
+            bytes += 2 * DIMS;
+        }
+        cube.reindex();
+        let& all = moves_by_id();
+        for (auto k = frame * interval; k < step; ++k) {
+            cube.rotate(all[ids[k]]);
+        }
+        return cube;
+    }
+
+    auto bytes() const -> size_t {
+        return ids.size() * sizeof(uint16_t) + keyframes.size();
+    }
+};
+
+// a batch of scrambles as a trie of their moves, so that a prefix they share is applied once.
+// each() walks it depth first, applying a move on the way down and its inverse on the way back
+// up, and hands over each scramble's state where the scramble ends.
+template <dim_t DIMS>
+class ScrambleTrie {
+    constexpr static uint32_t NONE = UINT32_MAX;
+    struct Node {
+        Rotation move;
+        uint32_t child = NONE;
+        uint32_t sibling = NONE;
+        // the first scramble that ends here; the rest follow through next_end.
+        uint32_t ends = NONE;
+    };
+    std::vector<Node> nodes = {Node{}};
+    std::vector<uint32_t> next_end;
+    size_t total = 0;
+
+public:
+    // adds a scramble, numbered from 0 in the order they are inserted.
+    auto insert(std::span<const Rotation> scramble) -> size_t {
+        uint32_t at = 0;
+        for (let& r : scramble) {
+            auto child = nodes[at].child;
+            while (child != NONE && !(nodes[child].move == r)) {
+                child = nodes[child].sibling;
+            }
+            if (child == NONE) {
+                child = nodes.size();
+                nodes.push_back(Node{r, NONE, nodes[at].child, NONE});
+                nodes[at].child = child;
+            }
+            at = child;
+        }
+        let index = next_end.size();
+        next_end.push_back(nodes[at].ends);
+        nodes[at].ends = index;
+        total += scramble.size();
+        return index;
+    }
+
+    // calls f(index, state) for every scramble, in trie order rather than by index.
+    template <typename F>
+    void each(F&& f) const {
+        Cube<DIMS> cube;
+        let ended = [&](uint32_t node) {
+            for (auto end = nodes[node].ends; end != NONE; end = next_end[end]) {
+                f((size_t)end, (const Cube<DIMS>&)cube);
+            }
+        };
+        ended(0);
+        // the nodes from the root down to the cube's state, each with the child to visit next.
+        std::vector<std::pair<uint32_t, uint32_t>> path = {{0, nodes[0].child}};
+        while (!path.empty()) {
+            let [node, next] = path.back();
+            if (next != NONE) {
+                path.back().second = nodes[next].sibling;
+                cube.rotate(nodes[next].move);
+                ended(next);
+                path.emplace_back(next, nodes[next].child);
+            } else {
+                if (node != 0) {
+                    cube.undo_rotation(nodes[node].move);
+                }
+                path.pop_back();
+            }
+        }
+    }
+
+    // every scramble's state, by index.
+    auto states() const -> std::vector<Cube<DIMS>> {
+        std::vector<Cube<DIMS>> cubes(size());
+        each([&](size_t index, const Cube<DIMS>& cube) { cubes[index] = cube; });
+        return cubes;
+    }
+
+    auto size() const -> size_t {
+        return next_end.size();
+    }
+
+    // the moves each() applies, against the moves of the scrambles one by one.
+    auto applied() const -> size_t {
+        return nodes.size() - 1;
+    }
+
+    auto moves() const -> size_t {
+        return total;
+    }
+};
+
+// builds and pages in tables on a background thread while the caller carries on.
+class Warmup {
+    std::thread worker;
+
+   public:
+    explicit Warmup(std::vector<std::function<void()>> jobs)
+        : worker([jobs = std::move(jobs)] {
+              for (let& job : jobs) {
+                  job();
+              }
+          }) {}
+
+    Warmup(const Warmup&) = delete;
+    auto operator=(const Warmup&) -> Warmup& = delete;
+
+    ~Warmup() {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+};
+
+template <dim_t DIMS>
+struct IdaStar {
+    // the two results that end a search outright, both below any bound.
+    constexpr static auto FOUND = -1;
+    constexpr static auto STOPPED = -2;
+    constexpr static auto NO_MOVE = UINT16_MAX;
+    using Values = typename Heuristic<DIMS>::Values;
+    const MoveTable<DIMS>& table;
+    const Heuristic<DIMS>* heuristic;
+    Cube<DIMS> cube;
+    // also bound each node by the heuristic of its inverse, which is exactly as far from solved.
+    bool dual = false;
+    // stop at this goal rather than at Cube::is_solved. the inverse of a state is not as far
+    // from a partial goal, so this turns dual lookups off.
+    const Goal<DIMS>* goal = nullptr;
+    // expand two plies at a time through these, when there are any.
+    const CompoundTable<DIMS>* compound = nullptr;
+    // finish from any state it holds, and prune any state near enough to be held that it lacks.
+    // like dual lookups, only used on the way to solved.
+    const EndgameTable<DIMS>* endgame = nullptr;
+    // give up, with no solution, as soon as this is set or once this many nodes are visited.
+    const std::atomic<bool>* stop = nullptr;
+    size_t max_nodes = SIZE_MAX;
+    std::vector<uint16_t> path = {};
+    size_t nodes = 0;
+    size_t dual_lookups = 0;
+    size_t dual_cutoffs = 0;
+    Cube<DIMS> inverse = {};
+    uint32_t usable = ~0u;
+
+    // the per-point bound gives the inverse the same value, so only the pattern databases are
+    // looked up again. they can't be tracked incrementally on the inverse (a move left-multiplies
+    // it), so the walk is capped just past what would prune, and only done when the
+    // cheap estimate failed to prune.
+    auto dual_estimate(int g, int bound) -> int {
+        ++dual_lookups;
+        cube.invert_into(inverse);
+        let cap = bound - g + 1;
+        return heuristic->combine(heuristic->evaluate(inverse, cap));
+    }
+
+    auto estimate(const Values& values) const -> int {
+        let h = goal ? goal->lower_bound(cube, table.metric) : cube.lower_bound(table.metric);
+        return heuristic ? std::max(h, heuristic->combine(values, usable)) : h;
+    }
+
+    auto at_goal() const -> bool {
+        return goal ? goal->holds(cube) : cube.is_solved();
+    }
+
+    // FOUND, STOPPED, a bound above `bound` to prune with, or zero to expand the node.
+    auto visit(int g, int bound, const Values& values) -> int {
+        if (++nodes > max_nodes || (stop && stop->load(std::memory_order_relaxed))) {
+            return STOPPED;
+        }
+        let h = estimate(values);
+        let f = g + h;
+        if (f > bound) {
+            return f;
+        }
+        if (at_goal()) {
+            return FOUND;
+        }
+        if (endgame && !goal && h <= endgame->depth) {
+            let held = endgame->find(cube) != nullptr;
+            let exact = held ? endgame->complete(cube, table) : std::nullopt;
+            // held but not completed is a key collision, which says nothing either way.
+            if (!held || exact) {
+                let far = g + (exact ? (int)exact->size() : endgame->depth + 1);
+                if (far > bound) {
+                    return far;
+                }
+                if (exact) {
+                    path.insert(path.end(), exact->begin(), exact->end());
+                    return FOUND;
+                }
+            }
+        }
+        if (dual && heuristic && !goal) {
+            let dual_f = g + dual_estimate(g, bound);
+            if (dual_f > bound) {
+                ++dual_cutoffs;
+                return dual_f;
+            }
+        }
+        return 0;
+    }
+
+    auto search(int g, int bound, uint16_t last, const Values& values) -> int {
+        if (let t = visit(g, bound, values); t != 0) {
+            return t;
+        }
+        auto next = INT_MAX;
+        for (uint16_t m = 0; m < table.size(); ++m) {
+            if (last != NO_MOVE && !table.follows(last, m)) {
+                continue;
+            }
+            cube.rotate(table.moves[m]);
+            path.push_back(m);
+            let t = search(g + 1, bound, m, heuristic ? heuristic->update(values, cube) : values);
+            if (t < 0) {
+                return t;
+            }
+            path.pop_back();
+            cube.rotate(table.moves[table.inverses[m]]);
+            next = std::min(next, t);
+        }
+        return next;
+    }
+
+    // any path is canonical pairs and perhaps one last single move, so singles are only tried
+    // as that last move, and a node is only expanded by pairs while two plies are left. the
+    // pattern databases are stepped through the first move of each group of pairs without
+    // touching the cube, so a group whose midpoint already prunes is skipped whole.
+    auto search_pairs(int g, int bound, uint16_t last, const Values& values) -> int {
+        if (let t = visit(g, bound, values); t != 0) {
+            return t;
+        }
+        for (uint16_t m = 0; m < table.size(); ++m) {
+            if (last != NO_MOVE && !table.follows(last, m)) {
+                continue;
+            }
+            cube.rotate(table.moves[m]);
+            let solved = at_goal();
+            cube.rotate(table.moves[table.inverses[m]]);
+            if (solved) {
+                path.push_back(m);
+                return FOUND;
+            }
+        }
+        if (bound - g < 2) {
+            return bound + 1;
+        }
+        auto next = INT_MAX;
+        let saved = cube;
+        using States = typename Heuristic<DIMS>::States;
+        let states = heuristic ? heuristic->project(cube) : States{};
+        States between_states;
+        States child_states;
+        Values between = values;
+        Values child = values;
+        for (uint16_t first = 0; first < table.size(); ++first) {
+            if (last != NO_MOVE && !table.follows(last, first)) {
+                continue;
+            }
+            if (heuristic) {
+                heuristic->advance(values, states, first, between, between_states);
+                let f = g + 1 + heuristic->combine(between, usable);
+                if (f > bound) {
+                    next = std::min(next, f);
+                    continue;
+                }
+            }
+            for (auto i = compound->begins[first]; i < compound->begins[first + 1]; ++i) {
+                let second = compound->pairs[i].second;
+                if (heuristic) {
+                    heuristic->advance(between, between_states, second, child, child_states);
+                }
+                compound->apply(cube, i);
+                path.push_back(first);
+                path.push_back(second);
+                let t = search_pairs(g + 2, bound, second, child);
+                if (t < 0) {
+                    return t;
+                }
+                path.resize(path.size() - 2);
+                cube = saved;
+                next = std::min(next, t);
+            }
+        }
+        return next;
+    }
+
+    auto run(int max_depth) -> std::optional<std::vector<Rotation>> {
+        if (goal && heuristic) {
+            usable = 0;
+            for (size_t i = 0; i < heuristic->dbs.size(); ++i) {
+                usable |= (uint32_t)goal->covers(heuristic->dbs[i]) << i;
+            }
+        }
+        let values = heuristic ? heuristic->evaluate(cube) : Values{0};
+        auto bound = estimate(values);
+        while (bound <= max_depth) {
+            let t = compound && !compound->pairs.empty() ? search_pairs(0, bound, NO_MOVE, values)
+                                                         : search(0, bound, NO_MOVE, values);
+            if (t == FOUND) {
+                std::vector<Rotation> result;
+                for (let m : path) {
+                    result.push_back(table.moves[m]);
+                }
+                return result;
+            }
+            if (t == STOPPED || t == INT_MAX) {
+                break;
+            }
+            bound = t;
+        }
+        return std::nullopt;
+    }
+};
+
+// the file write_solution_db() writes: solutions for particular states, found by the hash of
+// what Cube::is_solved looks at. keys are in eytzinger order, the implicit tree of a binary
+// search laid out breadth first from slot 1, so a lookup is a branch-free descent whose next few
+// levels share a cache line that can be prefetched. the span in the same slot locates the
+// solution among the move ids, which number moves as every_move() does.
+struct SolutionDbHeader {
+    constexpr static uint32_t VERSION = 1;
+    std::array<char, 4> magic = {'N', 'D', 'C', 'S'};
+    uint32_t version = VERSION;
+    uint64_t num_entries = 0;
+    // num_entries + 1 u64 keys and SolutionSpans each, slot 0 unused, then the u16 move ids.
+    uint64_t keys_at = 0;
+    uint64_t spans_at = 0;
+    uint64_t moves_at = 0;
+    uint64_t num_moves = 0;
+    uint8_t dims = 0;
+    // the Metric the solutions were found in.
+    uint8_t metric = 0;
+    std::array<uint8_t, 6> reserved = {0};
+};
+
+struct SolutionSpan {
+    uint32_t offset;
+    uint16_t length;
+    uint16_t reserved;
+};
+
+// writes the shortest of the solutions given for each distinct state to path.
+template <dim_t DIMS>
+void write_solution_db(const std::string& path, std::span<const Cube<DIMS>> cubes,
+                       std::span<const std::vector<Rotation>> solutions, Metric metric) {
+    assert(cubes.size() == solutions.size());
+    let& table = every_move<DIMS>();
+    let solved = Goal<DIMS>::solved();
+    std::vector<std::pair<uint64_t, size_t>> order;
+    for (size_t i = 0; i < cubes.size(); ++i) {
+        order.emplace_back(solved.hash(cubes[i]), i);
+    }
+    std::sort(order.begin(), order.end(), [&](let& a, let& b) {
+        return a.first != b.first ? a.first < b.first : solutions[a.second].size() < solutions[b.second].size();
+    });
+    order.erase(std::unique(order.begin(), order.end(), [](let& a, let& b) { return a.first == b.first; }), order.end());
+
+    let n = order.size();
+    std::vector<uint64_t> keys(n + 1, 0);
+    std::vector<SolutionSpan> spans(n + 1, SolutionSpan{0, 0, 0});
+    std::vector<uint16_t> moves;
+    // an in-order walk of the implicit tree meets the slots in sorted order.
+    size_t next = 0;
+    let place = [&](auto& self, size_t k) -> void {
+        if (k > n) {
+            return;
+        }
+        self(self, 2 * k);
+        let& solution = solutions[order[next].second];
+        keys[k] = order[next++].first;
+        spans[k] = SolutionSpan{(uint32_t)moves.size(), (uint16_t)solution.size(), 0};
+        for (let r : solution) {
+            moves.push_back(table.id_of(r));
+        }
+        self(self, 2 * k + 1);
+    };
+    place(place, 1);
+    assert(moves.size() <= UINT32_MAX);
+
+    SolutionDbHeader header;
+    header.num_entries = n;
+    header.num_moves = moves.size();
+    header.dims = DIMS;
+    header.metric = (uint8_t)metric;
+    // keys on a cache line boundary, so that each prefetch covers whole levels.
+    header.keys_at = 64;
+    header.spans_at = header.keys_at + keys.size() * sizeof(uint64_t);
+    header.moves_at = header.spans_at + spans.size() * sizeof(SolutionSpan);
+    std::vector<std::byte> file(header.moves_at + moves.size() * sizeof(uint16_t));
+    std::memcpy(file.data(), &header, sizeof(header));
+    std::memcpy(file.data() + header.keys_at, keys.data(), keys.size() * sizeof(uint64_t));
+    std::memcpy(file.data() + header.spans_at, spans.data(), spans.size() * sizeof(SolutionSpan));
+    std::memcpy(file.data() + header.moves_at, moves.data(), moves.size() * sizeof(uint16_t));
+
+    let fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "open " + path);
+    }
+    for (size_t at = 0; at < file.size();) {
+        let wrote = write(fd, file.data() + at, file.size() - at);
+        if (wrote < 0 && errno != EINTR) {
+            let error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "write " + path);
+        }
+        at += std::max<ssize_t>(wrote, 0);
+    }
+    if (close(fd) != 0) {
+        throw std::system_error(errno, std::generic_category(), "close " + path);
+    }
+}
+
+// a file from write_solution_db(), mapped read-only and shared, so every process that opens
+// it reads the same pages.
+class SolutionDb {
+    const std::byte* base = nullptr;
+    size_t length = 0;
+    SolutionDbHeader header;
+    const uint64_t* keys = nullptr;
+    const SolutionSpan* spans = nullptr;
+    const uint16_t* moves = nullptr;
+
+public:
+    explicit SolutionDb(const std::string& path) {
+        let fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+        let size = lseek(fd, 0, SEEK_END);
+        let mapped = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        let map_error = size > 0 ? errno : EINVAL;
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::system_error(map_error, std::generic_category(), "mmap " + path);
+        }
+        base = (const std::byte*)mapped;
+        length = size;
+        if (length >= sizeof(header)) {
+            std::memcpy(&header, base, sizeof(header));
+        }
+        let n = header.num_entries + 1;
+        let valid = length >= sizeof(header) && header.magic == SolutionDbHeader{}.magic &&
+                    header.version == SolutionDbHeader::VERSION && header.keys_at % 8 == 0 &&
+                    header.spans_at == header.keys_at + n * sizeof(uint64_t) &&
+                    header.moves_at == header.spans_at + n * sizeof(SolutionSpan) &&
+                    length >= header.moves_at + header.num_moves * sizeof(uint16_t);
+        if (!valid) {
+            munmap(mapped, length);
+            throw std::system_error(EINVAL, std::generic_category(), "not a solution database: " + path);
+        }
+        keys = (const uint64_t*)(base + header.keys_at);
+        spans = (const SolutionSpan*)(base + header.spans_at);
+        moves = (const uint16_t*)(base + header.moves_at);
+    }
+
+    SolutionDb(const SolutionDb&) = delete;
+    auto operator=(const SolutionDb&) -> SolutionDb& = delete;
+
+    ~SolutionDb() {
+        munmap((void*)base, length);
+    }
+
+    auto size() const -> size_t {
+        return header.num_entries;
+    }
+
+    // the move ids stored under key, empty if there are none. an empty solution is stored
+    // under the solved state's key alone.
+    auto find(uint64_t key) const -> std::span<const uint16_t> {
+        let n = header.num_entries;
+        size_t k = 1;
+        while (k <= n) {
+            // the slots three levels down from k share the cache line at 8k.
+            __builtin_prefetch(keys + 8 * k);
+            k = 2 * k + (keys[k] < key);
+        }
+        // undo the right turns taken since the last left one, landing on the first key not below.
+        k >>= std::countr_one(k) + 1;
+        if (k == 0 || keys[k] != key) {
+            return {};
+        }
+        let span = spans[k];
+        if (span.offset + span.length > header.num_moves) {
+            return {};
+        }
+        return {moves + span.offset, span.length};
+    }
+
+    // the stored solution for cube, if there is one for the metric and it does solve it.
+    template <dim_t DIMS>
+    auto lookup(const Cube<DIMS>& cube, Metric metric) const -> std::optional<std::vector<Rotation>> {
+        if (header.dims != DIMS || header.metric != (uint8_t)metric) {
+            return std::nullopt;
+        }
+        static let solved = Goal<DIMS>::solved();
+        let ids = find(solved.hash(cube));
+        let& table = every_move<DIMS>();
+        if (ids.empty() || std::any_of(ids.begin(), ids.end(), [&](auto id) { return id >= table.size(); })) {
+            return std::nullopt;
+        }
+        std::vector<Rotation> solution;
+        auto scratch = cube;
+        for (let id : ids) {
+            solution.push_back(table.moves[id]);
+            scratch.rotate(solution.back());
+        }
+        if (!scratch.is_solved()) {
+            return std::nullopt;
+        }
+        return solution;
+    }
+};
+
+struct SolveOptions {
+    int max_depth = 20;
+    bool dual = true;
+    // serve the request with the stochastic solver while tables are still warming, rather than blocking on them.
+    bool allow_fallback = true;
+    size_t fallback_iterations = 100000;
+    // expand two plies per step through the compound tables. this pays where the pattern
+    // databases do most of the pruning, as on Cube<3>; with more dimensions the per-point and
+    // dual bounds matter more, and they are only checked every other ply.
+    bool compound = false;
+    Metric metric = Metric::QUARTER;
+    // finish searches for solved through the table of every state a few moves from it.
+    bool endgame = true;
+    // answer from these stored solutions where they have one in the metric.
+    const SolutionDb* db = nullptr;
+    // give up, with no solution, once this is set, from another thread say.
+    const std::atomic<bool>* stop = nullptr;
+    // or once a search has visited this many nodes.
+    size_t max_nodes = SIZE_MAX;
+};
+
+template <dim_t DIMS>
+auto compound_for(const SolveOptions& opts) -> const CompoundTable<DIMS>* {
+    return opts.compound ? &Tables<DIMS>::instance(opts.metric).compound.get() : nullptr;
+}
+
+template <dim_t DIMS>
+auto endgame_for(const SolveOptions& opts) -> const EndgameTable<DIMS>* {
+    return opts.endgame ? &Tables<DIMS>::instance(opts.metric).endgame.get() : nullptr;
+}
+
+template <dim_t DIMS>
+auto solve(const Cube<DIMS>& cube, const SolveOptions& opts = {}) -> std::optional<std::vector<Rotation>> {
+    if (opts.db) {
+        if (auto stored = opts.db->lookup(cube, opts.metric)) {
+            return stored;
+        }
+    }
+    auto& tables = Tables<DIMS>::instance(opts.metric);
+    if (opts.allow_fallback && !tables.ready()) {
+        auto scratch = cube;
+        auto rotations = scratch.solve(opts.fallback_iterations);
+        if (scratch.is_solved()) {
+            return rotations;
+        }
+    }
+    return IdaStar<DIMS>{tables.moves.get(), &tables.heuristic.get(), cube, opts.dual, nullptr,
+                         compound_for<DIMS>(opts), endgame_for<DIMS>(opts), opts.stop, opts.max_nodes}
+        .run(opts.max_depth);
+}
+
+template <dim_t DIMS>
+auto solve_to(const Cube<DIMS>& cube, const Goal<DIMS>& goal, const SolveOptions& opts = {})
+    -> std::optional<std::vector<Rotation>> {
+    auto& tables = Tables<DIMS>::instance(opts.metric);
+    return IdaStar<DIMS>{tables.moves.get(), &tables.heuristic.get(), cube, false, &goal, compound_for<DIMS>(opts),
+                         nullptr, opts.stop, opts.max_nodes}
+        .run(opts.max_depth);
+}
+
+// the state whose solutions take a to b: undoing b, then doing a, is b^-1 a, and any moves that
+// solve it are a^-1 b. so every solved-state table serves, and the moves apply to a as they come.
+// b is reached as far as Cube::is_solved can tell, so its centres may end up turned.
+template <dim_t DIMS>
+auto relative(const Cube<DIMS>& a, const Cube<DIMS>& b) -> Cube<DIMS> {
+    auto composed = Permutation<DIMS>::identity();
+    Permutation<DIMS>::from(b.inverse()).compose_into(Permutation<DIMS>::from(a), composed);
+    return composed.to_cube();
+}
+
+template <dim_t DIMS>
+auto solve_between(const Cube<DIMS>& a, const Cube<DIMS>& b, const SolveOptions& opts = {})
+    -> std::optional<std::vector<Rotation>> {
+    return solve(relative(a, b), opts);
+}
+
+// solves through each goal in turn; later goals should include earlier ones to keep them.
+template <dim_t DIMS>
+auto solve_staged(Cube<DIMS> cube, std::span<const Goal<DIMS>> stages, const SolveOptions& opts = {})
+    -> std::optional<std::vector<Rotation>> {
+    std::vector<Rotation> result;
+    for (let& goal : stages) {
+        let stage = solve_to(cube, goal, opts);
+        if (!stage) {
+            return std::nullopt;
+        }
+        for (let r : *stage) {
+            cube.rotate(r);
+            result.push_back(r);
+        }
+    }
+    return result;
+}
+
+// follows a cube from a stream of its moves, keeping a solution of the current state up to date.
+// each move is made in place and its inverse goes in front of the solution, where it is merged
+// with the moves it meets there, so apply() takes microseconds. once no move has come for
+// `idle`, a background thread solves the state optimally and takes that solution instead when it
+// is shorter. a move that comes meanwhile, or the destructor, cancels that solve, so a state
+// only gets one once it has sat still for `idle` and then for as long as solving it takes.
+template <dim_t DIMS>
+class Tracker {
+    // how far into the solution a new move looks for one to merge with.
+    constexpr static size_t WINDOW = 8;
+
+    // a solution kept back to front, so that the next move to make is moves.back().
+    struct Solution {
+        std::vector<Rotation> moves;
+        int length = 0;
+
+        // moves on one axis commute when they turn different layers.
+        static auto commute(Rotation a, Rotation b) -> bool {
+            return a.axis == b.axis && a.side != b.side;
+        }
+
+        static auto same_layer(Rotation a, Rotation b) -> bool {
+            return a.axis == b.axis && a.side == b.side && std::minmax(a.from, a.to) == std::minmax(b.from, b.to);
+        }
+
+        // merges moves[p] with the next move after it that turns the same layer, across moves
+        // that commute with it: into nothing, or into one move where the metric has it.
+        auto merge(size_t p, Metric metric) -> bool {
+            let a = moves[p];
+            for (size_t k = 1; k <= WINDOW && k <= p; ++k) {
+                let q = p - k;
+                let b = moves[q];
+                if (!same_layer(a, b)) {
+                    if (!commute(a, b)) {
+                        return false;
+                    }
+                    continue;
+                }
+                let steps = (a.steps() + b.steps()) % 4;
+                if (steps == 2 && metric != Metric::HALF && a.turns == 1 && b.turns == 1) {
+                    return false;
+                }
+                let lo = std::min(a.from, a.to);
+                let hi = std::max(a.from, a.to);
+                length -= a.cost(metric) + b.cost(metric);
+                moves.erase(moves.begin() + p);
+                if (steps == 0) {
+                    moves.erase(moves.begin() + q);
+                } else {
+                    moves[q] = steps == 2 ? Rotation{a.axis, lo, hi, a.side, 2}
+                                          : Rotation{a.axis, steps == 1 ? lo : hi, steps == 1 ? hi : lo, a.side};
+                    length += moves[q].cost(metric);
+                }
+                return true;
+            }
+            return false;
+        }
+
+        void prepend(Rotation r, Metric metric) {
+            moves.push_back(r);
+            length += r.cost(metric);
+            // a merge shortens the solution, so this ends; the moves it brings together may merge in turn.
+            for (auto changed = true; changed;) {
+                changed = false;
+                let top = moves.size();
+                for (size_t p = top; p-- > 0 && top - p <= WINDOW && !changed;) {
+                    changed = merge(p, metric);
+                }
+            }
+        }
+    };
+
+    SolveOptions opts;
+    std::chrono::steady_clock::duration idle;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    mutable std::condition_variable done;
+    Cube<DIMS> cube;
+    Solution current;
+    // set to cancel the background solve, which then comes back empty.
+    std::atomic<bool> cancel = false;
+    // the moves made while the background solve works on the state from before them. they
+    // cancel it, but it may already have come back with a solution for them to go in front of.
+    std::vector<Rotation> since;
+    uint64_t generation = 0;
+    // the generation the background thread last solved, or is solving.
+    uint64_t tried = 0;
+    bool solving = false;
+    bool is_optimal = true;
+    bool stopping = false;
+    std::chrono::steady_clock::time_point last_move;
+    std::thread worker;
+
+    void run() {
+        std::unique_lock lock(mutex);
+        while (!stopping) {
+            if (tried == generation) {
+                wake.wait(lock);
+                continue;
+            }
+            let due = last_move + idle;
+            if (std::chrono::steady_clock::now() < due) {
+                wake.wait_until(lock, due);
+                continue;
+            }
+            tried = generation;
+            let snapshot = cube;
+            since.clear();
+            cancel.store(false, std::memory_order_relaxed);
+            solving = true;
+            lock.unlock();
+            let found = solve(snapshot, opts);
+            lock.lock();
+            solving = false;
+            if (found) {
+                Solution replacement;
+                for (auto r = found->rbegin(); r != found->rend(); ++r) {
+                    replacement.prepend(*r, opts.metric);
+                }
+                for (let r : since) {
+                    replacement.prepend(r.inverse(), opts.metric);
+                }
+                if (replacement.length <= current.length) {
+                    current = std::move(replacement);
+                    is_optimal = since.empty();
+                }
+            }
+            done.notify_all();
+        }
+    }
+
+public:
+    // tracks a cube that starts solved. the background solves never fall back to the stochastic
+    // solver, since a stochastic solution is no reason to stop looking.
+    explicit Tracker(SolveOptions options = {}, std::chrono::milliseconds idle = std::chrono::milliseconds(200))
+        : opts(options), idle(idle) {
+        opts.allow_fallback = false;
+        opts.stop = &cancel;
+        worker = std::thread([this] { run(); });
+    }
+
+    Tracker(const Tracker&) = delete;
+    auto operator=(const Tracker&) -> Tracker& = delete;
+
+    ~Tracker() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+            cancel.store(true, std::memory_order_relaxed);
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    // makes the move and returns the length of the solution from the new state, in the metric.
+    auto apply(Rotation r) -> int {
+        std::unique_lock lock(mutex);
+        cube.rotate(r);
+        current.prepend(r.inverse(), opts.metric);
+        if (solving) {
+            since.push_back(r);
+            cancel.store(true, std::memory_order_relaxed);
+        }
+        // a waiting worker only needs waking when it had nothing to do; otherwise it is
+        // counting down to the last due time and will see the new one then.
+        let was_waiting = tried == generation;
+        ++generation;
+        last_move = std::chrono::steady_clock::now();
+        is_optimal = false;
+        let length = current.length;
+        lock.unlock();
+        if (was_waiting) {
+            wake.notify_one();
+        }
+        return length;
+    }
+
+    // blocks until the background thread has solved the current state, or given up on it.
+    void wait() const {
+        std::unique_lock lock(mutex);
+        done.wait(lock, [&] { return tried == generation && !solving; });
+    }
+
+    auto solution() const -> std::vector<Rotation> {
+        std::lock_guard lock(mutex);
+        return std::vector<Rotation>(current.moves.rbegin(), current.moves.rend());
+    }
+
+    auto length() const -> int {
+        std::lock_guard lock(mutex);
+        return current.length;
+    }
+
+    auto state() const -> Cube<DIMS> {
+        std::lock_guard lock(mutex);
+        return cube;
+    }
+
+    // whether the solution is an optimal solve of the current state.
+    auto optimal() const -> bool {
+        std::lock_guard lock(mutex);
+        return is_optimal;
+    }
+};
+
+// parses sysfs cpulists such as "0-3,8,10-11".
+inline auto parse_cpulist(const std::string& list) -> std::vector<int> {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        let dash = range.find('-');
+        let first = std::atoi(range.c_str());
+        let last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+        for (auto cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// the cpus of each NUMA node that has any. without NUMA information in sysfs,
+// this is a single node holding every cpu.
+inline auto numa_nodes() -> std::vector<std::vector<int>> {
+    std::vector<std::vector<int>> nodes;
+    // node numbers need not be contiguous, so take them from the online list rather than counting up.
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string online_list;
+    std::getline(online, online_list);
+    for (let node : parse_cpulist(online_list)) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        std::getline(file, list);
+        if (auto cpus = parse_cpulist(list); !cpus.empty()) {
+            nodes.push_back(std::move(cpus));
+        }
+    }
+    if (nodes.empty()) {
+        nodes.emplace_back(std::max(1u, std::thread::hardware_concurrency()));
+        std::iota(nodes[0].begin(), nodes[0].end(), 0);
+    }
+    return nodes;
+}
+
+inline void pin_to(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (let cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// a permutation group as a base and strong generating set, built by random schreier-sims.
+// a permutation maps point i to p[i]. with a chance under 2^-40 the chain falls short of the
+// whole group, but anything contains() accepts is certainly in it, since sifting it down to the
+// identity writes it as a product of the generators.
+class PermutationGroup {
+public:
+    using Perm = std::vector<uint32_t>;
+
+private:
+    constexpr static int32_t OUTSIDE = -1;
+    constexpr static int32_t ROOT = INT32_MAX;
+    // consecutive random elements that must sift through before the chain is taken as complete.
+    constexpr static auto SURE = 40;
+
+    struct Level {
+        uint32_t base = 0;
+        // indices into strong of the generators that fix every earlier base point.
+        std::vector<uint32_t> gens;
+        // the generator that first reached each point of the base's orbit.
+        std::vector<int32_t> via;
+        std::vector<uint32_t> orbit;
+    };
+
+    size_t degree;
+    std::vector<Perm> strong;
+    std::vector<Perm> inverses;
+    std::vector<Level> levels;
+
+    static auto compose(const Perm& a, const Perm& b) -> Perm {
+        Perm c(a.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            c[i] = b[a[i]];
+        }
+        return c;
+    }
+
+    static auto invert(const Perm& a) -> Perm {
+        Perm c(a.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            c[a[i]] = i;
+        }
+        return c;
+    }
+
+    // grows the orbit by what the newest generator reaches, then by everything reaches from there.
+    void extend(Level& level) const {
+        if (level.orbit.empty()) {
+            level.via.assign(degree, OUTSIDE);
+            level.via[level.base] = ROOT;
+            level.orbit.push_back(level.base);
+        }
+        let newest = level.gens.back();
+        let old = level.orbit.size();
+        for (size_t q = 0; q < old; ++q) {
+            let y = strong[newest][level.orbit[q]];
+            if (level.via[y] == OUTSIDE) {
+                level.via[y] = newest;
+                level.orbit.push_back(y);
+            }
+        }
+        for (auto q = old; q < level.orbit.size(); ++q) {
+            for (let g : level.gens) {
+                let y = strong[g][level.orbit[q]];
+                if (level.via[y] == OUTSIDE) {
+                    level.via[y] = g;
+                    level.orbit.push_back(y);
+                }
+            }
+        }
+    }
+
+    // divides h by coset representatives until it fixes every base point, or its image of one
+    // falls outside that level's orbit. gives the level it stopped at.
+    auto sift(Perm& h) const -> size_t {
+        for (size_t i = 0; i < levels.size(); ++i) {
+            let& level = levels[i];
+            auto x = h[level.base];
+            if (level.via[x] == OUTSIDE) {
+                return i;
+            }
+            while (x != level.base) {
+                let& inverse = inverses[level.via[x]];
+                for (auto& v : h) {
+                    v = inverse[v];
+                }
+                x = inverse[x];
+            }
+        }
+        return levels.size();
+    }
+
+    // sifts h in, extending the chain with what is left of it. false if nothing was.
+    auto add(Perm h) -> bool {
+        let stopped = sift(h);
+        if (stopped == levels.size()) {
+            let moved = std::find_if(h.begin(), h.end(), [i = 0u](auto v) mutable { return v != i++; });
+            if (moved == h.end()) {
+                return false;
+            }
+            levels.emplace_back().base = moved - h.begin();
+        }
+        inverses.push_back(invert(h));
+        strong.push_back(std::move(h));
+        for (size_t j = 0; j <= stopped && j < levels.size(); ++j) {
+            levels[j].gens.push_back(strong.size() - 1);
+            extend(levels[j]);
+        }
+        return true;
+    }
+
+public:
+    PermutationGroup(size_t degree, std::span<const Perm> generators, uint64_t seed = 1) : degree(degree) {
+        if (generators.empty()) {
+            return;
+        }
+        for (let& g : generators) {
+            add(g);
+        }
+        // random elements by product replacement, with an accumulator to spread them further.
+        auto rng = SplitMix{seed};
+        std::vector<Perm> slots;
+        for (size_t i = 0; i < std::max<size_t>(10, generators.size()); ++i) {
+            slots.push_back(generators[i % generators.size()]);
+        }
+        auto accumulator = slots[0];
+        let shake = [&] {
+            let i = rng.below(slots.size());
+            auto j = rng.below(slots.size() - 1);
+            j += j >= i;
+            slots[i] = compose(slots[i], slots[j]);
+            accumulator = compose(accumulator, slots[i]);
+            return accumulator;
+        };
+        for (auto i = 0; i < 50; ++i) {
+            shake();
+        }
+        for (auto sifted = 0; sifted < SURE;) {
+            sifted = add(shake()) ? 0 : sifted + 1;
+        }
+    }
+
+    auto contains(Perm h) const -> bool {
+        if (sift(h) != levels.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < h.size(); ++i) {
+            if (h[i] != i) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    auto log10_order() const -> double {
+        return std::accumulate(levels.begin(), levels.end(), 0.0, [](double sum, let& level) {
+            return sum + std::log10((double)level.orbit.size());
+        });
+    }
+};
+
+// how a move permutes markers slot * DIMS + axis: where the piece in each slot goes, and where
+// each of its axes then points, except on centres, whose markers only follow the piece. that is
+// what Cube::is_solved looks at, so moves that generate these permutations reach every state
+// it tells apart.
+template <dim_t DIMS>
+auto marker_permutation(Rotation r) -> PermutationGroup::Perm {
+    constexpr auto NUM_POINTS = ipow(3, DIMS);
+    PermutationGroup::Perm perm(NUM_POINTS * DIMS);
+    for (uint32_t s = 0; s < NUM_POINTS; ++s) {
+        auto p = Point<DIMS>::from_index(s);
+        let center = p.is_center();
+        p.rotate(r);
+        for (size_t j = 0; j < DIMS; ++j) {
+            perm[s * DIMS + (center ? j : p.orientation[j])] = p.index() * DIMS + j;
+        }
+    }
+    return perm;
+}
+
+// the moves of the metric on a small set of layers, chosen greedily, that still generate every
+// state. a layer comes with all its moves, so the set is closed under inverses. layers are added
+// in order until the rest follow from them, then any that the later ones made redundant are
+// dropped. 3D gives five faces of six.
+template <dim_t DIMS>
+auto generating_moves(Metric metric = Metric::QUARTER) -> std::vector<Rotation> {
+    constexpr auto DEGREE = ipow(3, DIMS) * DIMS;
+    let all = Rotation::all<DIMS>(metric);
+    let layer_of = [](const Rotation& r) {
+        return std::tuple{r.axis, r.side, std::min(r.from, r.to), std::max(r.from, r.to)};
+    };
+    std::vector<decltype(layer_of(all[0]))> layers;
+    std::vector<std::vector<PermutationGroup::Perm>> layer_perms;
+    for (let& r : all) {
+        let layer = layer_of(r);
+        let at = std::find(layers.begin(), layers.end(), layer) - layers.begin();
+        if ((size_t)at == layers.size()) {
+            layers.push_back(layer);
+            layer_perms.emplace_back();
+        }
+        layer_perms[at].push_back(marker_permutation<DIMS>(r));
+    }
+    let group_of = [&](const std::vector<size_t>& chosen) {
+        std::vector<PermutationGroup::Perm> gens;
+        for (let l : chosen) {
+            gens.insert(gens.end(), layer_perms[l].begin(), layer_perms[l].end());
+        }
+        return PermutationGroup(DEGREE, gens);
+    };
+    let generates = [&](const PermutationGroup& group, size_t l) {
+        return std::all_of(layer_perms[l].begin(), layer_perms[l].end(), [&](let& p) { return group.contains(p); });
+    };
+
+    std::vector<size_t> chosen;
+    auto group = group_of(chosen);
+    for (size_t l = 0; l < layers.size(); ++l) {
+        if (!generates(group, l)) {
+            chosen.push_back(l);
+            group = group_of(chosen);
+        }
+    }
+    for (size_t i = chosen.size(); i-- > 0;) {
+        auto without = chosen;
+        without.erase(without.begin() + i);
+        let smaller = group_of(without);
+        if (generates(smaller, chosen[i])) {
+            chosen = std::move(without);
+        }
+    }
+
+    std::vector<Rotation> moves;
+    for (let& r : all) {
+        let at = std::find(layers.begin(), layers.end(), layer_of(r)) - layers.begin();
+        if (std::find(chosen.begin(), chosen.end(), (size_t)at) != chosen.end()) {
+            moves.push_back(r);
+        }
+    }
+    return moves;
+}
+
+// solves with only the moves in `moves`, which should be closed under inverses as
+// generating_moves() makes them. the generators are a fraction of the full set, 20 of 48 moves
+// in 4D and 34 of 120 in 5D, and fall further behind with more dimensions, so this is for cubes
+// whose full set branches too widely to search at all; in 3D and 4D solve(), with its endgame
+// table, does better. a solution in them is one in every move too, so the full metric's pattern
+// databases still bound the distance from below; the endgame and compound tables assume every
+// move and sit this out. what comes back are full-set moves as they are, though a state that
+// wants a dropped layer can take many more of them than the optimum, and long to find, so give
+// the search a max_depth or max_nodes it can afford.
+template <dim_t DIMS>
+auto solve_restricted(const Cube<DIMS>& cube, const MoveTable<DIMS>& moves, const SolveOptions& opts = {})
+    -> std::optional<std::vector<Rotation>> {
+    assert(moves.metric == opts.metric);
+    let& heuristic = Tables<DIMS>::instance(opts.metric).heuristic.get();
+    return IdaStar<DIMS>{moves, &heuristic, cube, opts.dual, nullptr, nullptr, nullptr, opts.stop, opts.max_nodes}
+        .run(opts.max_depth);
+}
+
+// an estimate of the distance to solved, by name, so estimates can be compared on the same states.
+template <dim_t DIMS>
+struct NamedHeuristic {
+    std::string name;
+    std::function<int(const Cube<DIMS>&)> estimate;
+};
+
+// the estimates the solvers have to hand: the greedy solver's score, the per-point bound, the
+// pattern databases, and those maxed together as IdaStar does, with and without the inverse.
+template <dim_t DIMS>
+auto registered_heuristics(Metric metric = Metric::QUARTER) -> std::vector<NamedHeuristic<DIMS>> {
+    let& heuristic = Tables<DIMS>::instance(metric).heuristic.get();
+    let patterns = [&heuristic](const Cube<DIMS>& cube) { return heuristic.combine(heuristic.evaluate(cube)); };
+    let combined = [=](const Cube<DIMS>& cube) { return std::max(cube.lower_bound(metric), patterns(cube)); };
+    return {
+        {"unsolvedness", [](const Cube<DIMS>& cube) { return cube.unsolvedness(); }},
+        {"lower_bound", [=](const Cube<DIMS>& cube) { return cube.lower_bound(metric); }},
+        {"patterns", patterns},
+        {"combined", combined},
+        {"combined+dual", [=](const Cube<DIMS>& cube) { return std::max(combined(cube), combined(cube.inverse())); }},
+    };
+}
+
+template <dim_t DIMS>
+struct DistanceSample {
+    Cube<DIMS> cube;
+    int distance;
+};
+
+// per_depth states from random walks of each length up to max_depth, none of whose moves undoes
+// or merges with the one before, each with its exact distance from an optimal solve.
+template <dim_t DIMS>
+auto sample_distances(size_t per_depth, int max_depth, uint64_t seed, Metric metric = Metric::QUARTER)
+    -> std::vector<DistanceSample<DIMS>> {
+    let& table = Tables<DIMS>::instance(metric).moves.get();
+    auto rng = SplitMix{seed};
+    std::vector<DistanceSample<DIMS>> samples;
+    for (int depth = 1; depth <= max_depth; ++depth) {
+        for (size_t n = 0; n < per_depth; ++n) {
+            Cube<DIMS> cube;
+            auto last = table.size();
+            for (int k = 0; k < depth; ++k) {
+                auto move = rng.below(table.size());
+                while (last < table.size() && !table.follows(last, move)) {
+                    move = rng.below(table.size());
+                }
+                cube.rotate(table.moves[move]);
+                last = move;
+            }
+            let solution = solve(cube, SolveOptions{.max_depth = depth, .allow_fallback = false, .metric = metric});
+            assert(solution);
+            samples.push_back({cube, solution_length(*solution, metric)});
+        }
+    }
+    return samples;
+}
+
+struct HeuristicReport {
+    std::string name;
+    // pearson, of the estimates against the true distances.
+    double correlation = 0;
+    // samples estimated above their true distance.
+    size_t violations = 0;
+    double nanoseconds = 0;
+    // korf's prediction of the nodes an IDA* iteration with this bound expands.
+    int bound = 0;
+    double predicted_nodes = 0;
+};
+
+// scores each heuristic on the samples. random_states, from long walks, stand in for the spread
+// of estimates over all states in the node prediction: depth i holds about M b^(i-1) nodes, b
+// being the moves left after MoveTable::follows prunes, and a node there is expanded when its
+// estimate is at most bound - i.
+template <dim_t DIMS>
+auto evaluate_heuristics(std::span<const NamedHeuristic<DIMS>> heuristics, std::span<const DistanceSample<DIMS>> samples,
+                         std::span<const Cube<DIMS>> random_states, int bound, Metric metric = Metric::QUARTER)
+    -> std::vector<HeuristicReport> {
+    let& table = Tables<DIMS>::instance(metric).moves.get();
+    let m = table.size();
+    size_t allowed = 0;
+    for (size_t last = 0; last < m; ++last) {
+        for (size_t move = 0; move < m; ++move) {
+            allowed += table.follows(last, move);
+        }
+    }
+    let branching = (double)allowed / m;
+
+    std::vector<HeuristicReport> reports;
+    for (let& heuristic : heuristics) {
+        HeuristicReport report;
+        report.name = heuristic.name;
+        std::vector<int> estimates;
+        let began = std::chrono::steady_clock::now();
+        for (let& sample : samples) {
+            estimates.push_back(heuristic.estimate(sample.cube));
+        }
+        for (let& cube : random_states) {
+            estimates.push_back(heuristic.estimate(cube));
+        }
+        let seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+        report.nanoseconds = estimates.empty() ? 0 : seconds * 1e9 / estimates.size();
+
+        double sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            let x = (double)estimates[i];
+            let y = (double)samples[i].distance;
+            sx += x, sy += y, sxx += x * x, syy += y * y, sxy += x * y;
+            report.violations += estimates[i] > samples[i].distance;
+        }
+        let n = (double)samples.size();
+        let spread = std::sqrt((n * sxx - sx * sx) * (n * syy - sy * sy));
+        report.correlation = spread > 0 ? (n * sxy - sx * sy) / spread : 0;
+
+        std::vector<int> spread_of(estimates.begin() + samples.size(), estimates.end());
+        std::sort(spread_of.begin(), spread_of.end());
+        let at_most = [&](int h) {
+            let count = std::upper_bound(spread_of.begin(), spread_of.end(), h) - spread_of.begin();
+            return spread_of.empty() ? 1.0 : (double)count / spread_of.size();
+        };
+        report.bound = bound;
+        report.predicted_nodes = 1;
+        auto width = (double)m;
+        for (int depth = 1; depth <= bound; ++depth) {
+            report.predicted_nodes += width * at_most(bound - depth);
+            width *= branching;
+        }
+        reports.push_back(std::move(report));
+    }
+    return reports;
+}
+
+// solves many cubes at once with one worker per cpu. on a multi-node machine each node
+// takes a contiguous share of the batch, and a thread pinned there copies the cubes and
+// every read-only table (moves, pattern databases, compound and endgame) before its workers
+// start, so first touch puts every page they read or write on their own node. on a single
+// node nothing is pinned or copied.
+template <dim_t DIMS>
+auto solve_batch(std::span<const Cube<DIMS>> cubes, const SolveOptions& opts = {}, const Goal<DIMS>* goal = nullptr)
+    -> std::vector<std::optional<std::vector<Rotation>>> {
+    auto& tables = Tables<DIMS>::instance(opts.metric);
+    let& shared_moves = tables.moves.get();
+    let& shared_heuristic = tables.heuristic.get();
+    let compound = compound_for<DIMS>(opts);
+    let endgame = goal ? nullptr : endgame_for<DIMS>(opts);
+    let nodes = numa_nodes();
+    let local = nodes.size() > 1;
+    let total_cpus = std::accumulate(nodes.begin(), nodes.end(), size_t{0}, [](size_t n, let& cpus) {
+        return n + cpus.size();
+    });
+
+    std::vector<std::optional<std::vector<Rotation>>> results(cubes.size());
+    std::vector<std::thread> leaders;
+    size_t begin = 0;
+    for (size_t node = 0; node < nodes.size(); ++node) {
+        let share = node + 1 == nodes.size() ? cubes.size() - begin : cubes.size() * nodes[node].size() / total_cpus;
+        let slice = cubes.subspan(begin, share);
+        let offset = begin;
+        begin += share;
+        leaders.emplace_back([&, node, slice, offset] {
+            if (local) {
+                pin_to(nodes[node]);
+            }
+            let moves = local ? std::make_unique<MoveTable<DIMS>>(shared_moves) : nullptr;
+            let heuristic = local ? std::make_unique<Heuristic<DIMS>>(shared_heuristic) : nullptr;
+            // the endgame table is probed at nearly every node of a search, so it is copied too.
+            let compound_copy = local && compound ? std::make_unique<CompoundTable<DIMS>>(*compound) : nullptr;
+            let endgame_copy = local && endgame ? std::make_unique<EndgameTable<DIMS>>(*endgame) : nullptr;
+            let node_compound = compound_copy ? compound_copy.get() : compound;
+            let node_endgame = endgame_copy ? endgame_copy.get() : endgame;
+            let mine = local ? std::vector<Cube<DIMS>>(slice.begin(), slice.end()) : std::vector<Cube<DIMS>>();
+            let& node_moves = local ? *moves : shared_moves;
+            let& node_heuristic = local ? *heuristic : shared_heuristic;
+            let node_cubes = local ? std::span<const Cube<DIMS>>(mine) : slice;
+
+            std::atomic<size_t> next = 0;
+            let work = [&] {
+                if (local) {
+                    pin_to(nodes[node]);
+                }
+                for (auto i = next++; i < node_cubes.size(); i = next++) {
+                    if (opts.db && !goal) {
+                        if (auto stored = opts.db->lookup(node_cubes[i], opts.metric)) {
+                            results[offset + i] = std::move(stored);
+                            continue;
+                        }
+                    }
+                    auto search = IdaStar<DIMS>{node_moves, &node_heuristic, node_cubes[i], opts.dual, goal,
+                                                node_compound, node_endgame, opts.stop, opts.max_nodes};
+                    results[offset + i] = search.run(opts.max_depth);
+                }
+            };
+            std::vector<std::thread> workers;
+            for (size_t w = 1; w < nodes[node].size(); ++w) {
+                workers.emplace_back(work);
+            }
+            work();
+            for (auto& w : workers) {
+                w.join();
+            }
+        });
+    }
+    for (auto& leader : leaders) {
+        leader.join();
+    }
+    return results;
+}
+
+// a recorded batch of seeded Cube::solve runs: each run's trace, and which worker ran which
+// runs in what order. runs are seeded from the batch seed and their index, so the order only
+// matters for profiling, but replaying it keeps the same runs sharing the same caches.
+struct AnnealTrace {
+    uint64_t seed = 0;
+    std::vector<SolveTrace> runs;
+    std::vector<std::vector<uint32_t>> workers;
+
+    static auto run_seed(uint64_t seed, size_t run) -> uint64_t {
+        return SplitMix{seed ^ (run * 0x9e3779b97f4a7c15)}.next();
+    }
+
+    // "NDCT", then u64 seed, u32 runs and workers, then each run's u64 seed, u64 steps and
+    // packed bits, then each worker's u32 count and run indices, all host-endian.
+    void save(std::ostream& out) const {
+        let put = [&](auto v) { out.write((const char*)&v, sizeof(v)); };
+        out.write("NDCT", 4);
+        put(seed);
+        put((uint32_t)runs.size());
+        put((uint32_t)workers.size());
+        for (let& run : runs) {
+            put(run.seed);
+            put((uint64_t)run.steps);
+            out.write((const char*)run.kept.data(), run.kept.size() * sizeof(uint64_t));
+        }
+        for (let& worker : workers) {
+            put((uint32_t)worker.size());
+            out.write((const char*)worker.data(), worker.size() * sizeof(uint32_t));
+        }
+    }
+
+    static auto load(std::istream& in) -> std::optional<AnnealTrace> {
+        let get = [&](auto& v) { return (bool)in.read((char*)&v, sizeof(v)); };
+        char magic[4];
+        AnnealTrace trace;
+        uint32_t num_runs, num_workers;
+        if (!in.read(magic, 4) || std::memcmp(magic, "NDCT", 4) || !get(trace.seed) || !get(num_runs) ||
+            !get(num_workers)) {
+            return std::nullopt;
+        }
+        trace.runs.resize(num_runs);
+        for (auto& run : trace.runs) {
+            uint64_t steps;
+            if (!get(run.seed) || !get(steps)) {
+                return std::nullopt;
+            }
+            run.steps = steps;
+            run.kept.resize((steps + 63) / 64);
+            if (!in.read((char*)run.kept.data(), run.kept.size() * sizeof(uint64_t))) {
+                return std::nullopt;
+            }
+        }
+        trace.workers.resize(num_workers);
+        for (auto& worker : trace.workers) {
+            uint32_t count;
+            if (!get(count)) {
+                return std::nullopt;
+            }
+            worker.resize(count);
+            if (!in.read((char*)worker.data(), count * sizeof(uint32_t))) {
+                return std::nullopt;
+            }
+            if (std::any_of(worker.begin(), worker.end(), [&](auto run) { return run >= num_runs; })) {
+                return std::nullopt;
+            }
+        }
+        return trace;
+    }
+};
+
+// runs Cube::solve on every cube, one worker per cpu taking the next cube as it finishes,
+// and records the runs and who ran them into trace.
+template <dim_t DIMS>
+auto anneal_batch(std::span<const Cube<DIMS>> cubes, uint64_t seed, AnnealTrace& trace,
+                  size_t max_iterations = SolveOptions{}.fallback_iterations) -> std::vector<std::vector<Rotation>> {
+    let threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::vector<Rotation>> results(cubes.size());
+    trace = AnnealTrace{seed, std::vector<SolveTrace>(cubes.size()), std::vector<std::vector<uint32_t>>(threads)};
+    std::atomic<size_t> next = 0;
+    let work = [&](unsigned worker) {
+        for (auto i = next++; i < cubes.size(); i = next++) {
+            auto cube = cubes[i];
+            results[i] = cube.solve_recorded(AnnealTrace::run_seed(seed, i), trace.runs[i], max_iterations);
+            trace.workers[worker].push_back((uint32_t)i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(work, t);
+    }
+    work(0);
+    for (auto& t : pool) {
+        t.join();
+    }
+    return results;
+}
+
+// repeats a recorded batch, on one thread in order of the cubes, or on a thread per recorded
+// worker, each running its runs in the recorded order. nullopt if any run comes out differently.
+template <dim_t DIMS>
+auto replay_batch(std::span<const Cube<DIMS>> cubes, const AnnealTrace& trace, bool threaded)
+    -> std::optional<std::vector<std::vector<Rotation>>> {
+    // every run, once.
+    std::vector<bool> seen(cubes.size(), false);
+    for (let& runs : trace.workers) {
+        for (let i : runs) {
+            if (i >= cubes.size() || seen[i]) {
+                return std::nullopt;
+            }
+            seen[i] = true;
+        }
+    }
+    if (trace.runs.size() != cubes.size() || std::find(seen.begin(), seen.end(), false) != seen.end()) {
+        return std::nullopt;
+    }
+    std::vector<std::vector<Rotation>> results(cubes.size());
+    std::atomic<bool> same = true;
+    let replay = [&](size_t i) {
+        auto cube = cubes[i];
+        auto rotations = cube.solve_replayed(trace.runs[i]);
+        if (!rotations) {
+            same = false;
+            return;
+        }
+        results[i] = std::move(*rotations);
+    };
+    if (!threaded) {
+        for (size_t i = 0; i < cubes.size(); ++i) {
+            replay(i);
+        }
+    } else {
+        std::vector<std::thread> pool;
+        for (let& runs : trace.workers) {
+            pool.emplace_back([&] {
+                for (let i : runs) {
+                    replay(i);
+                }
+            });
+        }
+        for (auto& t : pool) {
+            t.join();
+        }
+    }
+    if (!same) {
+        return std::nullopt;
+    }
+    return results;
+}
+
+// a (scramble, solution) pair as two adjacent ranges of one shared buffer of move ids.
+struct MovePair {
+    uint32_t scramble;
+    uint32_t solution;
+    uint32_t end;
+};
+
+// the index of every pair whose solution does not take its scramble back to solved. each
+// sequence is compiled into a single permutation on its own, then the two are composed.
+// move ids are those of every_move().
+template <dim_t DIMS>
+auto verify_all(std::span<const uint16_t> moves, std::span<const MovePair> pairs) -> std::vector<size_t> {
+    let& table = every_move<DIMS>();
+    std::mutex mutex;
+    std::vector<size_t> failures;
+    parallel_for(pairs.size(), 1024, [&](size_t begin, size_t end) {
+        auto scramble = Permutation<DIMS>::identity();
+        auto solution = Permutation<DIMS>::identity();
+        auto combined = Permutation<DIMS>::identity();
+        std::vector<size_t> local;
+        for (auto i = begin; i < end; ++i) {
+            let& pair = pairs[i];
+            scramble.reset();
+            solution.reset();
+            for (auto m = pair.scramble; m < pair.solution; ++m) {
+                scramble.apply(table, moves[m]);
+            }
+            for (auto m = pair.solution; m < pair.end; ++m) {
+                solution.apply(table, moves[m]);
+            }
+            scramble.compose_into(solution, combined);
+            if (!combined.is_identity()) {
+                local.push_back(i);
+            }
+        }
+        let lock = std::lock_guard(mutex);
+        failures.insert(failures.end(), local.begin(), local.end());
+    });
+    std::sort(failures.begin(), failures.end());
+    return failures;
+}
+
+// the file export_cayley() writes, for analysis tools to mmap. the graph is regular, one edge
+// per generator out of every state, so the CSR offsets are implicit: the edges of state r are
+// the num_generators targets at edges_at + r * num_generators * index_bytes, in generator order.
+struct CayleyHeader {
+    constexpr static uint32_t VERSION = 1;
+    std::array<char, 4> magic = {'N', 'D', 'C', 'G'};
+    uint32_t version = VERSION;
+    uint64_t num_states = 0;
+    // a multiple of the page size, so the edges can be mapped on their own.
+    uint64_t edges_at = 0;
+    uint32_t num_generators = 0;
+    uint8_t dims = 0;
+    // 4, or 8 once the ranks outgrow 32 bits.
+    uint8_t index_bytes = 0;
+    std::array<uint8_t, 2> reserved = {0};
+};
+
+// follows the header, one per generator.
+struct CayleyGenerator {
+    dim_t axis;
+    dim_t from;
+    dim_t to;
+    uint8_t side;
+    uint8_t turns;
+    std::array<uint8_t, 3> reserved;
+};
+
+// writes the state graph of the sub-puzzle `spec` tracks under the generators to path, states
+// numbered by PatternSpace::rank. every arrangement of the pieces is ranked, so states the
+// generators can't reach show up as components of their own. rows are built in parallel
+// straight into the mapped file, which is refused up front, with EFBIG or ENOSPC, if its size
+// can't be counted or the filesystem has no room for it; a mapped write past the free space
+// would only fail as SIGBUS.
+template <dim_t DIMS>
+void export_cayley(const std::string& path, const PatternSpec& spec, std::span<const Rotation> generators) {
+    let& table = every_move<DIMS>();
+    std::vector<uint16_t> moves;
+    for (let& r : generators) {
+        moves.push_back(table.id_of(r));
+        assert(moves.back() < table.size());
+    }
+    let space = PatternSpace<DIMS>(table, spec);
+    CayleyHeader header;
+    header.num_states = space.size();
+    header.num_generators = moves.size();
+    header.dims = DIMS;
+    header.index_bytes = space.size() > UINT32_MAX ? 8 : 4;
+    let page = (uint64_t)sysconf(_SC_PAGESIZE);
+    header.edges_at = (sizeof(CayleyHeader) + sizeof(CayleyGenerator) * moves.size() + page - 1) / page * page;
+    uint64_t length = 0;
+    if (!space.fits || __builtin_mul_overflow(header.num_states, moves.size() * header.index_bytes, &length) ||
+        __builtin_add_overflow(length, header.edges_at, &length) || length > (uint64_t)std::numeric_limits<off_t>::max()) {
+        throw std::system_error(EFBIG, std::generic_category(), "cayley graph for " + path);
+    }
+
+    let fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "open " + path);
+    }
+    struct statvfs fs;
+    if (fstatvfs(fd, &fs) == 0 && (unsigned __int128)fs.f_bavail * fs.f_frsize < length) {
+        close(fd);
+        unlink(path.c_str());
+        throw std::system_error(ENOSPC, std::generic_category(), std::to_string(length) + " bytes for " + path);
+    }
+    if (ftruncate(fd, length) != 0) {
+        close(fd);
+        throw std::system_error(errno, std::generic_category(), "ftruncate " + path);
+    }
+    let mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    let map_error = errno;
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw std::system_error(map_error, std::generic_category(), "mmap " + path);
+    }
+    let base = (std::byte*)mapped;
+    std::memcpy(base, &header, sizeof(header));
+    for (size_t i = 0; i < generators.size(); ++i) {
+        let& r = generators[i];
+        let g = CayleyGenerator{r.axis, r.from, r.to, (uint8_t)r.side, r.turns, {0}};
+        std::memcpy(base + sizeof(header) + i * sizeof(g), &g, sizeof(g));
+    }
+    let edges = base + header.edges_at;
+    let k = moves.size();
+    parallel_for(header.num_states, 4096, [&](size_t begin, size_t end) {
+        for (auto r = begin; r < end; ++r) {
+            let state = space.unrank(r);
+            for (size_t j = 0; j < k; ++j) {
+                let target = space.rank(space.apply(state, moves[j]));
+                let at = edges + (r * k + j) * header.index_bytes;
+                if (header.index_bytes == 4) {
+                    let narrow = (uint32_t)target;
+                    std::memcpy(at, &narrow, 4);
+                } else {
+                    std::memcpy(at, &target, 8);
+                }
+            }
+        }
+    });
+    let synced = msync(mapped, length, MS_SYNC);
+    let error = errno;
+    munmap(mapped, length);
+    if (synced != 0) {
+        throw std::system_error(error, std::generic_category(), "msync " + path);
+    }
+}
+
+inline void backoff(unsigned& spins) {
+    if (++spins < 64) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+// bounded multi-producer multi-consumer queue (Vyukov's). it holds no pointers, so it
+// works the same from every process that maps it.
+template <class T, size_t CAPACITY>
+class RingBuffer {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0);
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+    struct Cell {
+        std::atomic<uint64_t> sequence;
+        T value;
+    };
+    alignas(64) std::atomic<uint64_t> head = 0;
+    alignas(64) std::atomic<uint64_t> tail = 0;
+    alignas(64) std::array<Cell, CAPACITY> cells;
+
+   public:
+    RingBuffer() {
+        for (uint64_t i = 0; i < CAPACITY; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    auto try_push(const T& value) -> bool {
+        auto pos = head.load(std::memory_order_relaxed);
+        loop {
+            auto& cell = cells[pos & (CAPACITY - 1)];
+            let lag = (int64_t)(cell.sequence.load(std::memory_order_acquire) - pos);
+            if (lag < 0) {
+                return false;
+            }
+            if (lag > 0) {
+                pos = head.load(std::memory_order_relaxed);
+            } else if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.value = value;
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    auto try_pop(T& out) -> bool {
+        auto pos = tail.load(std::memory_order_relaxed);
+        loop {
+            auto& cell = cells[pos & (CAPACITY - 1)];
+            let lag = (int64_t)(cell.sequence.load(std::memory_order_acquire) - (pos + 1));
+            if (lag < 0) {
+                return false;
+            }
+            if (lag > 0) {
+                pos = tail.load(std::memory_order_relaxed);
+            } else if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                out = cell.value;
+                cell.sequence.store(pos + CAPACITY, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    // how many values consumers have claimed so far, so that a single producer, knowing the
+    // order it pushed in, can tell which of its values have been taken.
+    auto popped() const -> uint64_t {
+        return tail.load(std::memory_order_acquire);
+    }
+};
+
+struct PoolRequest {
+    constexpr static auto MAX_MOVES = 256;
+    // sent once per worker to shut it down.
+    constexpr static uint16_t STOP = UINT16_MAX;
+    uint64_t id;
+    uint16_t length;
+    std::array<uint16_t, MAX_MOVES> moves;
+};
+
+struct PoolResponse {
+    constexpr static auto MAX_MOVES = 64;
+    constexpr static uint16_t UNSOLVED = UINT16_MAX;
+    uint64_t id;
+    uint16_t length;
+    std::array<uint16_t, MAX_MOVES> moves;
+};
+
+// solver processes forked from a supervisor. the pattern databases and a pair of request and
+// response queues live in one POSIX shared memory segment, so every worker reads the same
+// single copy of the databases (mapped read-only once filled) and scrambles travel without
+// sockets. the move and endgame tables are built before the fork and shared copy-on-write.
+// a worker that dies is replaced, and the supervisor sends what it had taken again; a scramble
+// that takes down a second worker fails. the segment is unlinked as soon as it is mapped, since
+// workers inherit the mapping, and workers die with the supervisor, so a supervisor that
+// crashes leaves nothing behind.
+template <dim_t DIMS>
+class ProcessPool {
+   public:
+    constexpr static size_t MAX_PROCESSES = 256;
+
+   private:
+    constexpr static size_t QUEUE = 1024;
+    constexpr static uint64_t IDLE = UINT64_MAX;
+
+    struct Header {
+        RingBuffer<PoolRequest, QUEUE> requests;
+        RingBuffer<PoolResponse, QUEUE> responses;
+        // the request id each worker is working on.
+        std::array<std::atomic<uint64_t>, MAX_PROCESSES> working;
+    };
+
+    pid_t supervisor = getpid();
+    std::byte* base = nullptr;
+    size_t length = 0;
+    Header* header = nullptr;
+    const MoveTable<DIMS>& moves;
+    // scrambles are sent as every_move() ids, so they may use moves the metric doesn't.
+    const MoveTable<DIMS>& scramble_moves;
+    // built before the workers fork, so they share its pages until anything writes them.
+    const EndgameTable<DIMS>* endgame;
+    // pattern spaces on the heap (inherited by the workers), distances viewing the segment.
+    Heuristic<DIMS> heuristic;
+    SolveOptions opts;
+    std::vector<pid_t> workers;
+    // answers drained by reap(), ahead of the ring, and requests given up on, after it.
+    std::deque<PoolResponse> arrived;
+    std::vector<PoolResponse> failed;
+    // the requests pushed and not yet popped, oldest first, and those popped and not answered.
+    // a worker publishes what it took only after popping it, so the supervisor keeps its own
+    // account of what was taken.
+    std::deque<PoolRequest> queued;
+    std::map<uint64_t, PoolRequest> claimed;
+    uint64_t pops_seen = 0;
+    // requests to send again, ahead of new ones, and the ids that have been sent again already.
+    std::deque<PoolRequest> resend;
+    std::set<uint64_t> resent;
+
+    auto push(const PoolRequest& request) -> bool {
+        if (!header->requests.try_push(request)) {
+            return false;
+        }
+        queued.push_back(request);
+        return true;
+    }
+
+    // sends what is waiting to go again, and says whether all of it went.
+    auto flush() -> bool {
+        while (!resend.empty() && push(resend.front())) {
+            resend.pop_front();
+        }
+        return resend.empty();
+    }
+
+    void sync_claims() {
+        for (let popped = header->requests.popped(); pops_seen < popped; ++pops_seen) {
+            claimed[queued.front().id] = queued.front();
+            queued.pop_front();
+        }
+    }
+
+    void spawn(size_t slot) {
+        header->working[slot].store(IDLE);
+        let pid = fork();
+        if (pid < 0) {
+            throw std::system_error(errno, std::generic_category(), "fork");
+        }
+        if (pid == 0) {
+            // the supervisor may have died before the request to follow it took hold.
+            if (prctl(PR_SET_PDEATHSIG, SIGKILL) != 0 || getppid() != supervisor) {
+                _exit(1);
+            }
+            work(slot);
+            _exit(0);
+        }
+        workers[slot] = pid;
+    }
+
+    void work(size_t slot) {
+        PoolRequest request;
+        unsigned spins = 0;
+        loop {
+            if (!header->requests.try_pop(request)) {
+                backoff(spins);
+                continue;
+            }
+            spins = 0;
+            if (request.length == PoolRequest::STOP) {
+                return;
+            }
+            header->working[slot].store(request.id);
+            auto cube = Cube<DIMS>();
+            for (size_t i = 0; i < request.length; ++i) {
+                cube.rotate(scramble_moves.moves[request.moves[i]]);
+            }
+            let solution = IdaStar<DIMS>{moves, &heuristic, cube, opts.dual, nullptr, nullptr, endgame, nullptr, opts.max_nodes}
+                                .run(opts.max_depth);
+            PoolResponse response{request.id, PoolResponse::UNSOLVED, {}};
+            if (solution && solution->size() <= PoolResponse::MAX_MOVES) {
+                response.length = solution->size();
+                for (size_t i = 0; i < solution->size(); ++i) {
+                    response.moves[i] = moves.id_of((*solution)[i]);
+                }
+            }
+            while (!header->responses.try_push(response)) {
+                backoff(spins);
+            }
+            header->working[slot].store(IDLE);
+        }
+    }
+
+   public:
+    explicit ProcessPool(size_t count, SolveOptions opts = {})
+        : moves(Tables<DIMS>::instance(opts.metric).moves.get()),
+          scramble_moves(every_move<DIMS>()),
+          endgame(endgame_for<DIMS>(opts)),
+          opts(opts),
+          workers(count) {
+        assert(count > 0 && count <= MAX_PROCESSES);
+        let& source = Tables<DIMS>::instance(opts.metric).heuristic.get();
+        let page = (size_t)sysconf(_SC_PAGESIZE);
+        let tables_at = (sizeof(Header) + page - 1) / page * page;
+        length = tables_at;
+        for (let& db : source.dbs) {
+            length += DistanceTable::num_words(db.distances.size()) * sizeof(uint64_t);
+        }
+
+        let name = "/ndcube-" + std::to_string(supervisor);
+        let fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "shm_open");
+        }
+        shm_unlink(name.c_str());
+        if (ftruncate(fd, length) != 0) {
+            let error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "ftruncate");
+        }
+        let mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        let map_error = errno;
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::system_error(map_error, std::generic_category(), "mmap");
+        }
+        base = (std::byte*)mapped;
+        header = new (base) Header();
+
+        auto words = (std::atomic<uint64_t>*)(base + tables_at);
+        heuristic.num_additive = source.num_additive;
+        for (let& db : source.dbs) {
+            heuristic.dbs.push_back(PatternDb<DIMS>{db.space, DistanceTable::copy_into(db.distances, words)});
+            words += DistanceTable::num_words(db.distances.size());
+        }
+        if (length > tables_at) {
+            mprotect(base + tables_at, length - tables_at, PROT_READ);
+        }
+
+        for (size_t slot = 0; slot < count; ++slot) {
+            spawn(slot);
+        }
+    }
+
+    ProcessPool(const ProcessPool&) = delete;
+    auto operator=(const ProcessPool&) -> ProcessPool& = delete;
+
+    ~ProcessPool() {
+        PoolRequest stop{0, PoolRequest::STOP, {}};
+        unsigned spins = 0;
+        for (size_t i = 0; i < workers.size(); ++i) {
+            while (!header->requests.try_push(stop)) {
+                backoff(spins);
+            }
+        }
+        for (let pid : workers) {
+            waitpid(pid, nullptr, 0);
+        }
+        header->~Header();
+        munmap(base, length);
+    }
+
+    // a scramble longer than a request holds is not sent, and comes back unsolved.
+    auto try_submit(uint64_t id, std::span<const Rotation> scramble) -> bool {
+        if (scramble.size() > PoolRequest::MAX_MOVES) {
+            failed.push_back(PoolResponse{id, PoolResponse::UNSOLVED, {}});
+            return true;
+        }
+        if (!flush()) {
+            return false;
+        }
+        PoolRequest request{id, (uint16_t)scramble.size(), {}};
+        for (size_t i = 0; i < scramble.size(); ++i) {
+            request.moves[i] = scramble_moves.id_of(scramble[i]);
+        }
+        return push(request);
+    }
+
+    auto try_collect() -> std::optional<std::pair<uint64_t, std::optional<std::vector<Rotation>>>> {
+        PoolResponse response;
+        if (!arrived.empty()) {
+            response = arrived.front();
+            arrived.pop_front();
+        } else if (header->responses.try_pop(response)) {
+            sync_claims();
+            claimed.erase(response.id);
+        } else if (!failed.empty()) {
+            response = failed.back();
+            failed.pop_back();
+        } else {
+            return std::nullopt;
+        }
+        if (response.length == PoolResponse::UNSOLVED) {
+            return std::pair{response.id, std::nullopt};
+        }
+        std::vector<Rotation> solution;
+        for (size_t i = 0; i < response.length; ++i) {
+            solution.push_back(moves.moves[response.moves[i]]);
+        }
+        return std::pair{response.id, std::optional(std::move(solution))};
+    }
+
+    // replaces workers that have died, and sends again every request that was taken, is not
+    // answered and is not held by a live worker, since a worker can die between taking a
+    // request and saying so. a request sent again is failed the next time. answers already in
+    // the ring are drained first, since a dead worker may have answered before dying, and a
+    // request with an answer is never failed. this can still repeat a request whose answer is
+    // on its way from a live worker, so callers keep the first answer per id.
+    void reap() {
+        flush();
+        int status;
+        std::vector<size_t> dead;
+        for (size_t slot = 0; slot < workers.size(); ++slot) {
+            if (waitpid(workers[slot], &status, WNOHANG) == workers[slot]) {
+                dead.push_back(slot);
+            }
+        }
+        if (dead.empty()) {
+            return;
+        }
+        sync_claims();
+        for (PoolResponse response; header->responses.try_pop(response);) {
+            claimed.erase(response.id);
+            arrived.push_back(response);
+        }
+        std::set<uint64_t> held;
+        for (size_t slot = 0; slot < workers.size(); ++slot) {
+            if (std::find(dead.begin(), dead.end(), slot) == dead.end()) {
+                held.insert(header->working[slot].load());
+            }
+        }
+        for (auto it = claimed.begin(); it != claimed.end();) {
+            if (held.contains(it->first)) {
+                ++it;
+                continue;
+            }
+            if (resent.insert(it->first).second) {
+                resend.push_back(it->second);
+            } else {
+                failed.push_back(PoolResponse{it->first, PoolResponse::UNSOLVED, {}});
+            }
+            it = claimed.erase(it);
+        }
+        for (let slot : dead) {
+            spawn(slot);
+        }
+        flush();
+    }
+
+    auto solve_all(std::span<const std::vector<Rotation>> scrambles) -> std::vector<std::optional<std::vector<Rotation>>> {
+        std::vector<std::optional<std::vector<Rotation>>> results(scrambles.size());
+        std::vector<bool> done(scrambles.size(), false);
+        size_t submitted = 0;
+        size_t finished = 0;
+        unsigned spins = 0;
+        while (finished < scrambles.size()) {
+            auto progress = false;
+            while (submitted < scrambles.size() && try_submit(submitted, scrambles[submitted])) {
+                ++submitted;
+                progress = true;
+            }
+            while (auto result = try_collect()) {
+                auto& [id, solution] = *result;
+                if (!done[id]) {
+                    done[id] = true;
+                    results[id] = std::move(solution);
+                    ++finished;
+                }
+                progress = true;
+            }
+            if (progress) {
+                spins = 0;
+            } else {
+                reap();
+                backoff(spins);
+            }
+        }
+        return results;
+    }
+};
+
+constexpr auto MIN_DIMS = 2;
+constexpr auto MAX_DIMS = 8;
+// cubes up to this can be turned, though only up to MAX_DIMS solved.
+constexpr auto MAX_PLAY_DIMS = 11;
+
+// calls f with std::integral_constant<dim_t, dims>, so runtime input can pick a Cube<DIMS>.
+template <dim_t D = MIN_DIMS, dim_t MAX = MAX_DIMS, class F>
+auto with_dims(int dims, F&& f) -> decltype(auto) {
+    if constexpr (D == MAX) {
+        assert(dims == D);
+        return f(std::integral_constant<dim_t, D>{});
+    } else {
+        if (dims == D) {
+            return f(std::integral_constant<dim_t, D>{});
+        }
+        return with_dims<D + 1, MAX>(dims, std::forward<F>(f));
+    }
+}
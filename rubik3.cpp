@@ -1,371 +1,780 @@
-#include <algorithm>
-#include <array>
-#include <cassert>
-#include <cstdint>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <numeric>
-#include <span>
+#include <iterator>
+#include <optional>
+#include <random>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
 
-namespace cag {
-// from https://stackoverflow.com/a/19023500/13243460
-template <class Function, std::size_t... Indices>
-constexpr auto make_array_helper(Function f, std::index_sequence<Indices...>)
-    -> std::array<typename std::result_of<Function(std::size_t)>::type, sizeof...(Indices)> {
-    return {{f(Indices)...}};
-}
+#include "ndcube.hpp"
 
-template <int N, class Function>
-constexpr auto make_array(Function f)
-    -> std::array<typename std::result_of<Function(std::size_t)>::type, N> {
-    return make_array_helper(f, std::make_index_sequence<N>{});
+auto not_in(dim_t e, const std::span<const dim_t> es) -> bool {
+    return std::find(es.begin(), es.end(), e) == es.end();
 }
-}  // namespace cag
-
-#define let const auto
-#define loop while (true)
-
-using coord_t = uint8_t;
-using dim_t = uint8_t;
-
-constexpr auto X = 0, Y = 1, Z = 2, W = 3;
-constexpr auto RED = "\u001b[31m";
-constexpr auto GREEN = "\u001b[32m";
-constexpr auto RESET = "\u001b[0m";
 
-constexpr int64_t ipow(int64_t base, int exp, int64_t result = 1) {
-    return exp < 1 ? result : ipow(base * base, exp / 2, (exp % 2) ? result * base : result);
+auto split(const std::string& string, const char sep) {
+    // consider switching to a search-and-allocate method if push_back becomes a performace bottleneck.
+    std::vector<std::string> result;
+    std::stringstream ss(string);
+    while (ss.good()) {
+        std::string substr;
+        std::getline(ss, substr, sep);
+        result.push_back(substr);
+    }
+    return result;
 }
 
-enum Side {
-    FRONT = 0,
-    BACK = 2,
-};
-
-struct Rotation {
-    dim_t axis;
-    dim_t from;
-    dim_t to;
-    Side side;
-
-    template <dim_t DIMS>
-    static auto random() -> Rotation {
-        auto side = (rand() & 1) * 2;
-        auto axis = rand() % DIMS;
-        auto from = rand() % DIMS;
-        while (from == axis) {
-            from = rand() % DIMS;
+// moves in the interactive format: the axis, from, to and side digits, then a fifth digit, 2, for
+// a half turn, with commas between moves. anything else, such as two moves run together, which
+// could be read more than one way, is rejected rather than guessed at.
+template <dim_t DIMS>
+auto parse_rotations(const std::string& input) -> std::optional<std::vector<Rotation>> {
+    std::vector<Rotation> result;
+    for (auto part : split(input, ',')) {
+        part.erase(0, part.find_first_not_of(" \t\r"));
+        part.erase(part.find_last_not_of(" \t\r") + 1);
+        if (part.empty()) {
+            continue;
+        }
+        let half = part.size() == 5 && part[4] == '2';
+        if ((part.size() != 4 && !half) || !std::all_of(part.begin(), part.end(), ::isdigit)) {
+            return std::nullopt;
         }
-        auto to = rand() % DIMS;
-        while (to == axis || to == from) {
-            to = rand() % DIMS;
+        let axis = (dim_t)(part[0] - '0');
+        let from = (dim_t)(part[1] - '0');
+        let to = (dim_t)(part[2] - '0');
+        let side = part[3] - '0';
+        if (axis >= DIMS || from >= DIMS || to >= DIMS || axis == from || from == to || to == axis || side > BACK) {
+            return std::nullopt;
         }
-        return Rotation{(dim_t)axis, (dim_t)from, (dim_t)to, (Side)side};
+        result.push_back(Rotation{axis, from, to, (Side)side, (uint8_t)(half ? 2 : 1)});
     }
-};
+    return result;
+}
 
+// one scramble per line on stdin, or nothing if a line doesn't parse, which is reported.
 template <dim_t DIMS>
-struct Point {
-    using vec = std::array<coord_t, DIMS>;
-    vec original_coords = {0};
-    vec coords = {0};
-    vec orientation = {0};
-
-    static auto create(vec input) -> Point {
-        vec orientation;
-        std::iota(orientation.begin(), orientation.end(), 0);
-        return Point{input, input, orientation};
+auto read_scrambles() -> std::optional<std::vector<std::vector<Rotation>>> {
+    std::vector<std::vector<Rotation>> scrambles;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        auto scramble = parse_rotations<DIMS>(line);
+        if (!scramble) {
+            std::cerr << "bad rotation on line " << scrambles.size() + 1 << std::endl;
+            return std::nullopt;
+        }
+        scrambles.push_back(std::move(*scramble));
     }
+    return scrambles;
+}
 
-    static auto from_index(size_t i) -> Point {
-        vec vals;
-        for (size_t index = 0; index < DIMS; ++index) {
-            let dividend = i / (ipow(3, index));
-            vals[index] = (dividend % 3);
-        }
-        return create(vals);
+constexpr auto INIT_DIMS = 2;
+
+auto parse_metric(const std::string& name) -> std::optional<Metric> {
+    if (name == "quarter") {
+        return Metric::QUARTER;
     }
+    if (name == "slice") {
+        return Metric::SLICE;
+    }
+    if (name == "half") {
+        return Metric::HALF;
+    }
+    return std::nullopt;
+}
 
-    void rotate(const Rotation r) {
-        let rotation_axis = r.axis;
-        let from_axis = r.from;
-        let to_axis = r.to;
+template <dim_t DIMS>
+auto interactive(const SolveOptions& opts) -> int {
+    std::cout << "The N-D Cube (where N is currently " << (int)DIMS << ")" << std::endl;
+    std::cout << "Enter rotations in the form of four digits (like 1230), where" << std::endl;
+    std::cout << " - the first digit is the axis to rotate around" << std::endl;
+    std::cout << " - the second digit is the axis to rotate from" << std::endl;
+    std::cout << " - the third digit is the axis to rotate to" << std::endl;
+    std::cout << " - the fourth digit is the side to rotate [either 0 or 2, or 1 for the slice between]" << std::endl;
+    std::cout << " - and an optional fifth digit, 2, makes it a half turn" << std::endl;
+    std::cout << "For example, to rotate the top face clockwise" << std::endl;
+    std::cout << " - we would be rotating around the Y axis (axis 1), " << std::endl;
+    std::cout << " - from the Z axis (2), " << std::endl;
+    std::cout << " - to the X axis (0), " << std::endl;
+    std::cout << " - and we would be rotating the face \"further in the Y direction\" (higher up) (2). " << std::endl;
+    std::cout << "So our command would be 1202." << std::endl;
+    std::cout << "Enter \"solve\" to have the cube solved for you." << std::endl;
 
-        assert(rotation_axis != from_axis && from_axis != to_axis && to_axis != rotation_axis);
-        assert(rotation_axis < DIMS && from_axis < DIMS && to_axis < DIMS);
+    auto c = Cube<DIMS>();
 
-        // is this point on the face that we're rotating?
-        if (coords[rotation_axis] != r.side) {
-            return;
-        }
+    // c.shuffle(100);
+
+    c.show();
 
-        // this is trivial
-        std::swap(orientation[from_axis], orientation[to_axis]);
+    loop {
+        std::string input;
+        std::cout << "Enter a rotation: ";
+        if (!(std::cin >> input)) {
+            return 0;
+        }
 
-        // this is not
-        switch (coords[from_axis]) {
-            case 0:
-                switch (coords[to_axis]) {
-                    case 0:
-                        coords[from_axis] = 2;
-                        coords[to_axis] = 0;
-                        break;
-                    case 1:
-                        coords[from_axis] = 1;
-                        coords[to_axis] = 0;
-                        break;
-                    case 2:
-                        coords[from_axis] = 0;
-                        coords[to_axis] = 0;
-                        break;
-                    default:
-                        assert(false);
-                }
-                break;
-            case 1:
-                switch (coords[to_axis]) {
-                    case 0:
-                        coords[from_axis] = 2;
-                        coords[to_axis] = 1;
-                        break;
-                    case 1:
-                        break;
-                    case 2:
-                        coords[from_axis] = 0;
-                        coords[to_axis] = 1;
-                        break;
-                    default:
-                        assert(false);
+        if (input == "solve") {
+            if constexpr (DIMS > MAX_DIMS) {
+                std::cout << "Only cubes of up to " << MAX_DIMS << " dimensions can be solved." << std::endl;
+                continue;
+            } else {
+                let solution = solve(c, opts);
+                if (!solution) {
+                    std::cout << "No solution found." << std::endl;
+                    continue;
                 }
-                break;
-            case 2:
-                switch (coords[to_axis]) {
-                    case 0:
-                        coords[from_axis] = 2;
-                        coords[to_axis] = 2;
-                        break;
-                    case 1:
-                        coords[from_axis] = 1;
-                        coords[to_axis] = 2;
-                        break;
-                    case 2:
-                        coords[from_axis] = 0;
-                        coords[to_axis] = 2;
-                        break;
-                    default:
-                        assert(false);
+                for (let r : *solution) {
+                    c.rotate(r);
                 }
-                break;
-            default:
-                assert(false);
+                std::cout << format_rotations(*solution) << " (" << solution_length(*solution, opts.metric) << " moves)"
+                          << std::endl;
+            }
+        } else if (let rotations = parse_rotations<DIMS>(input)) {
+            for (let r : *rotations) {
+                c.rotate(r);
+            }
+        } else {
+            std::cout << "Moves are four digits, and a fifth, 2, for a half turn, separated by commas." << std::endl;
+            continue;
         }
-    }
 
-    auto is_in_original_position() const -> bool {
-        return coords == original_coords;
-    }
-
-    auto is_in_original_orientation() const -> bool {
-        return std::is_sorted(orientation.begin(), orientation.end());
+        c.show();
     }
+}
 
-    auto is_center() const -> bool {
-        return std::count(coords.begin(), coords.end(), 1) == DIMS - 1;
+// the whole of `text` as a number in [min, max], or nothing.
+auto parse_number(const std::string& text, int min, int max) -> std::optional<int> {
+    int value = 0;
+    let end = text.data() + text.size();
+    let [at, error] = std::from_chars(text.data(), end, value);
+    if (error != std::errc() || at != end || value < min || value > max) {
+        return std::nullopt;
     }
+    return value;
+}
 
-    auto to_string() const -> std::string {
-        std::stringstream out;
-        out << RESET;
-        out << "Current coordinates: ";
-        if (is_in_original_position()) {
-            out << GREEN;
-        } else {
-            out << RED;
-        }
-        for (auto c : coords) out << (int)c << " ";
-        out << RESET;
-        out << "Orientation: ";
-        if (is_in_original_orientation()) {
-            out << GREEN;
+// goals such as "placed=0+oriented" or "face=1,2": terms joined by '+' must all hold.
+template <dim_t DIMS>
+auto parse_goal(const std::string& spec) -> std::optional<Goal<DIMS>> {
+    std::vector<GoalTerm> terms;
+    for (let& term : split(spec, '+')) {
+        let eq = term.find('=');
+        let name = term.substr(0, eq);
+        let args = eq == std::string::npos ? std::vector<std::string>{} : split(term.substr(eq + 1), ',');
+        if (name == "solved" && args.empty()) {
+            terms.push_back(GoalTerm{});
+        } else if (name == "oriented" && args.empty()) {
+            terms.push_back(GoalTerm{.position = false});
+        } else if (name == "placed" && args.size() == 1) {
+            let ones = parse_number(args[0], 0, DIMS - 1);
+            if (!ones) {
+                return std::nullopt;
+            }
+            terms.push_back(GoalTerm{.ones = (dim_t)*ones, .orientation = false});
+        } else if (name == "face" && args.size() == 2) {
+            let axis = parse_number(args[0], 0, DIMS - 1);
+            let side = parse_number(args[1], FRONT, BACK);
+            if (!axis || !side || *side == MIDDLE) {
+                return std::nullopt;
+            }
+            terms.push_back(GoalTerm{.face = std::pair{(dim_t)*axis, (Side)*side}});
         } else {
-            out << RED;
+            return std::nullopt;
         }
-        for (auto c : orientation) out << (int)c << " ";
-        out << RESET;
-        out << "Original coordinates: ";
-        for (auto c : original_coords) out << (int)c << " ";
-        return out.str();
     }
+    return Goal<DIMS>::compile(terms);
+}
 
-    auto dist_from_original() const -> int {
-        return std::transform_reduce(
-            coords.begin(), coords.end(), 
-            original_coords.begin(),
-            0, std::plus{}, [](auto a, auto b) {
-                return std::abs(a - b);
-            });
-    }
+auto usage() -> int;
 
-    auto incorrectness() const -> int {
-        auto smallmod = is_in_original_orientation() ? 0 : 1;
-        return dist_from_original() + smallmod * 10;
+// one scramble per line on stdin, in the interactive format; one solution per line on stdout.
+// with processes > 0 the scrambles go to that many forked workers instead of threads. restricted
+// searches only generating_moves(), for cubes whose full move set branches too widely.
+template <dim_t DIMS>
+auto batch(size_t processes, const std::optional<std::string>& goal_spec, bool restricted, const SolveOptions& opts,
+           const std::optional<std::string>& save_db) -> int {
+    let goal = goal_spec ? parse_goal<DIMS>(*goal_spec) : std::nullopt;
+    if (goal_spec && !goal) {
+        std::cerr << "--goal " << *goal_spec << " is not a goal for " << (int)DIMS << " dimensions" << std::endl;
+        return usage();
+    }
+    if ((goal_spec || restricted) && processes > 0) {
+        std::cerr << (goal_spec ? "--goal" : "--restricted") << " works with threads only" << std::endl;
+        return 2;
+    }
+    if (goal_spec && restricted) {
+        std::cerr << "--restricted solves to solved, not to a goal" << std::endl;
+        return 2;
+    }
+    let scrambles = read_scrambles<DIMS>();
+    if (!scrambles) {
+        return 2;
+    }
+    ScrambleTrie<DIMS> trie;
+    for (let& scramble : *scrambles) {
+        trie.insert(scramble);
     }
-};
+    let cubes = trie.states();
+    std::vector<std::optional<std::vector<Rotation>>> solutions;
+    if (processes > 0) {
+        for (size_t i = 0; i < scrambles->size(); ++i) {
+            if ((*scrambles)[i].size() > PoolRequest::MAX_MOVES) {
+                std::cerr << "scramble on line " << i + 1 << " rejected: worker processes take at most "
+                          << PoolRequest::MAX_MOVES << " moves" << std::endl;
+            }
+        }
+        solutions = ProcessPool<DIMS>(processes, opts).solve_all(*scrambles);
+    } else if (restricted) {
+        let moves = MoveTable<DIMS>::build(generating_moves<DIMS>(opts.metric), opts.metric);
+        solutions.resize(cubes.size());
+        parallel_for(cubes.size(), 1, [&](size_t begin, size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                solutions[i] = solve_restricted(cubes[i], *moves, opts);
+            }
+        });
+    } else {
+        solutions = solve_batch<DIMS>(cubes, opts, goal ? &*goal : nullptr);
+    }
+    for (let& solution : solutions) {
+        std::cout << (solution ? format_rotations(*solution) : "unsolved") << std::endl;
+    }
+    if (save_db) {
+        if (goal) {
+            std::cerr << "--save-db keeps solutions to solved, not to a goal" << std::endl;
+            return 2;
+        }
+        std::vector<Cube<DIMS>> solved_cubes;
+        std::vector<std::vector<Rotation>> found;
+        for (size_t i = 0; i < cubes.size(); ++i) {
+            if (solutions[i]) {
+                solved_cubes.push_back(cubes[i]);
+                found.push_back(*solutions[i]);
+            }
+        }
+        try {
+            write_solution_db<DIMS>(*save_db, solved_cubes, found, opts.metric);
+        } catch (const std::system_error& e) {
+            std::cerr << "cannot save the solutions: " << e.what() << std::endl;
+            return 2;
+        }
+    }
+    return 0;
+}
 
+// solves the scrambles on stdin with the stochastic solver, recording the run to a file, or
+// replays a recorded run on the same scrambles and checks that it goes the same way.
 template <dim_t DIMS>
-struct Cube {
-    constexpr static auto NUM_POINTS = ipow(3, DIMS);
-    constexpr static std::array AXES = cag::make_array<DIMS>([](auto i) { return (dim_t)i; });
-    std::array<Point<DIMS>, NUM_POINTS> points;
-
-    Cube() {
-        for (size_t idx = 0; idx < NUM_POINTS; ++idx) {
-            points[idx] = Point<DIMS>::from_index(idx);
+auto anneal(const std::optional<std::string>& record, const std::optional<std::string>& replay, bool serial) -> int {
+    let scrambles = read_scrambles<DIMS>();
+    if (!scrambles) {
+        return 2;
+    }
+    ScrambleTrie<DIMS> trie;
+    for (let& scramble : *scrambles) {
+        trie.insert(scramble);
+    }
+    let cubes = trie.states();
+    let began = std::chrono::steady_clock::now();
+    std::vector<std::vector<Rotation>> solutions;
+    if (replay) {
+        std::ifstream in(*replay, std::ios::binary);
+        let trace = AnnealTrace::load(in);
+        if (!trace) {
+            std::cerr << "cannot read a trace from " << *replay << std::endl;
+            return 2;
+        }
+        auto replayed = replay_batch<DIMS>(cubes, *trace, !serial);
+        if (!replayed) {
+            std::cerr << "the replay went differently from the recording" << std::endl;
+            return 1;
+        }
+        solutions = std::move(*replayed);
+    } else {
+        AnnealTrace trace;
+        solutions = anneal_batch<DIMS>(cubes, std::random_device{}(), trace);
+        std::ofstream out(*record, std::ios::binary);
+        trace.save(out);
+        if (!out) {
+            std::cerr << "cannot write the trace to " << *record << std::endl;
+            return 2;
         }
     }
-
-    void rotate(Rotation r) {
-        std::for_each(
-            points.begin(),
-            points.end(),
-            [this, r](auto& p) {
-                p.rotate(r);
-            });
+    let seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+    for (size_t i = 0; i < cubes.size(); ++i) {
+        auto cube = cubes[i];
+        for (let r : solutions[i]) {
+            cube.rotate(r);
+        }
+        std::cout << (cube.is_solved() ? format_rotations(solutions[i]) : "unsolved") << std::endl;
     }
+    std::cerr << cubes.size() << " runs in " << seconds << "s" << std::endl;
+    return 0;
+}
 
-    void rotate_n(Rotation r, size_t n) {
-        for (size_t i = 0; i < n; ++i) {
-            rotate(r);
+// scores every registered heuristic on states up to `depth` moves from solved, with a fixed
+// seed so that runs compare.
+template <dim_t DIMS>
+auto evaluate(int depth, Metric metric) -> int {
+    constexpr auto PER_DEPTH = 20;
+    constexpr auto RANDOM_STATES = 1000;
+    constexpr auto WALK = 100;
+    let began = std::chrono::steady_clock::now();
+    let samples = sample_distances<DIMS>(PER_DEPTH, depth, 1, metric);
+    let& table = Tables<DIMS>::instance(metric).moves.get();
+    auto rng = SplitMix{2};
+    std::vector<Cube<DIMS>> random_states(RANDOM_STATES);
+    for (auto& cube : random_states) {
+        for (auto k = 0; k < WALK; ++k) {
+            cube.rotate(table.moves[rng.below(table.size())]);
         }
     }
-
-    void undo_rotation(Rotation r) {
-        rotate_n(r, 3);
+    let heuristics = registered_heuristics<DIMS>(metric);
+    let reports = evaluate_heuristics<DIMS>(heuristics, samples, random_states, depth, metric);
+    let seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+    std::cout << samples.size() << " samples up to " << depth << " moves, " << random_states.size()
+              << " random states, in " << seconds << "s" << std::endl;
+    std::cout << "heuristic        correlation  violations       ns  nodes at bound " << depth << std::endl;
+    for (let& report : reports) {
+        std::cout << std::left << std::setw(16) << report.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << report.correlation << std::setw(12) << report.violations << std::setw(9)
+                  << std::setprecision(0) << report.nanoseconds << std::scientific << std::setprecision(2)
+                  << std::setw(16) << report.predicted_nodes << std::defaultfloat << std::endl;
     }
+    return 0;
+}
 
-    auto is_solved() const -> bool {
-        return std::all_of(
-            points.begin(),
-            points.end(),
-            [](let p) {
-                return p.is_in_original_position() && (p.is_in_original_orientation() || p.is_center());
-            });
+// prints how many states lie at each distance from solved, up to `depth`, with a bloom filter
+// for the visited set so that it runs past what an exact set could hold.
+template <dim_t DIMS>
+auto layers(int depth, Metric metric) -> int {
+    constexpr uint64_t MAX_STATES = uint64_t{1} << 24;
+    constexpr auto RATE = 1e-4;
+    auto seen = BloomFilter::sized_for(MAX_STATES, RATE);
+    let began = std::chrono::steady_clock::now();
+    let counts = count_layers<DIMS>(depth, MAX_STATES, seen, metric);
+    let seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+    uint64_t total = 0;
+    for (size_t d = 0; d < counts.size(); ++d) {
+        std::cout << d << " " << counts[d] << std::endl;
+        total += counts[d];
     }
+    std::cerr << total << " states in " << seconds << "s, " << seen.bytes() / (1 << 20)
+              << " MiB of filter, false positive rate about " << seen.expected_rate(total) << std::endl;
+    return 0;
+}
 
-    auto unsolvedness() const -> int {
-        return std::transform_reduce(
-            points.begin(), points.end(),
-            0, std::plus{}, [](let p) {
-                return p.incorrectness();
-            });
+// follows a cube through the moves on stdin as they come, in the interactive format, and after
+// each line prints the length of a solution from there and how long updating it took. at the
+// end the solution itself goes to stdout.
+template <dim_t DIMS>
+auto track(const SolveOptions& opts) -> int {
+    Tracker<DIMS> tracker(opts);
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        let began = std::chrono::steady_clock::now();
+        let rotations = parse_rotations<DIMS>(line);
+        if (!rotations) {
+            std::cerr << "bad rotation: " << line << std::endl;
+            continue;
+        }
+        auto length = tracker.length();
+        for (let r : *rotations) {
+            length = tracker.apply(r);
+        }
+        let micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - began).count();
+        std::cout << length << " " << micros << "us" << (tracker.optimal() ? " optimal" : "") << std::endl;
     }
+    std::cout << format_rotations(tracker.solution()) << std::endl;
+    return 0;
+}
 
-    void show() const {
-        std::cout << "Current state: " << std::endl;
-        for (auto p : points) {
-            std::cout << p.to_string() << std::endl;
-        }
-        std::cout << "Solved? " << (is_solved() ? "Yes" : "No") << std::endl;
-        std::cout << "Unsolvedness: " << unsolvedness() << std::endl;
+// prints a small set of the metric's moves that still reaches every state, and the size of the
+// group it generates, which should be that of the full set's.
+template <dim_t DIMS>
+auto generators(Metric metric) -> int {
+    let began = std::chrono::steady_clock::now();
+    let moves = generating_moves<DIMS>(metric);
+    let all = Rotation::all<DIMS>(metric);
+    std::vector<PermutationGroup::Perm> perms;
+    for (let& r : moves) {
+        perms.push_back(marker_permutation<DIMS>(r));
     }
+    let group = PermutationGroup(ipow(3, DIMS) * DIMS, perms);
+    let seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+    std::cout << format_rotations(moves) << std::endl;
+    std::cerr << moves.size() << " of " << all.size() << " moves, 10^" << group.log10_order() << " states, in "
+              << seconds << "s" << std::endl;
+    return 0;
+}
 
-    void shuffle(size_t times) {
-        for (size_t i = 0; i < times; ++i) {
-            rotate(Rotation::random<DIMS>());
+// reads (scramble, solution) pairs from stdin and reports the pairs that don't solve.
+// text input has one pair per line, the two sequences in the interactive format separated by
+// whitespace. binary input starts with "NDCV" and a dimension byte, then holds records of a
+// u16 scramble length, a u16 solution length and that many u16 move ids, all host-endian.
+// ids number moves as Rotation::every() does: the face quarter turns, then the slice quarter
+// turns, then the half turns, so the face quarter turns keep the ids they have in every metric.
+template <dim_t DIMS>
+auto verify() -> int {
+    let& table = every_move<DIMS>();
+    let input = std::string(std::istreambuf_iterator<char>(std::cin), {});
+    std::vector<uint16_t> moves;
+    std::vector<MovePair> pairs;
+
+    if (input.starts_with("NDCV")) {
+        if (input.size() < 5 || input[4] != DIMS) {
+            std::cerr << "binary input is not for " << (int)DIMS << " dimensions" << std::endl;
+            return 2;
         }
-    }
-    
-    void solve() {
-        std::vector<Rotation> rotations;
-        while (!is_solved()) {
-            let last_unsolvedness = unsolvedness();
-            let r = Rotation::random<DIMS>();
-            rotate(r);
-            rotations.push_back(r);
-            let random_value = rand() % 100;
-            let current_unsolvedness = unsolvedness();
-            if (current_unsolvedness > last_unsolvedness) {
-                if (random_value < 90) {
-                    undo_rotation(r);
-                    rotations.pop_back();
+        let read = [&](size_t at) {
+            uint16_t v;
+            std::memcpy(&v, input.data() + at, sizeof(v));
+            return v;
+        };
+        for (size_t at = 5; at < input.size();) {
+            let length = at + 4 <= input.size() ? read(at) + read(at + 2) : SIZE_MAX;
+            if (at + 4 + 2 * length > input.size()) {
+                std::cerr << "truncated record at byte " << at << std::endl;
+                return 2;
+            }
+            let start = (uint32_t)moves.size();
+            pairs.push_back(MovePair{start, start + read(at), start + (uint32_t)length});
+            for (size_t i = 0; i < length; ++i) {
+                moves.push_back(read(at + 4 + 2 * i));
+                if (moves.back() >= table.size()) {
+                    std::cerr << "bad move id " << moves.back() << " at byte " << at << std::endl;
+                    return 2;
                 }
-            } else {
-                if (random_value < 10) {
-                    undo_rotation(r);
-                    rotations.pop_back();
+            }
+            at += 4 + 2 * length;
+        }
+    } else {
+        // four digits (axis, from, to, side) index straight into the move ids, offset past
+        // the quarter turns for a half turn's fifth digit. a half turn goes either way round.
+        constexpr auto HALF = ipow(10, 4);
+        std::vector<int> ids(2 * HALF, -1);
+        for (size_t m = 0; m < table.size(); ++m) {
+            let r = table.moves[m];
+            let key = std::stoi(r.to_string().substr(0, 4));
+            ids[key + (r.turns == 2 ? HALF : 0)] = m;
+            if (r.turns == 2) {
+                ids[std::stoi(Rotation{r.axis, r.to, r.from, r.side}.to_string()) + HALF] = m;
+            }
+        }
+        let parse = [&](std::string_view seq) {
+            for (size_t at = 0; at < seq.size(); ++at) {
+                if (seq[at] == ',' || seq[at] == '\r') {
+                    continue;
+                }
+                let digits = seq.substr(at, 4);
+                let valid = digits.size() == 4 && std::all_of(digits.begin(), digits.end(), ::isdigit);
+                let half = valid && at + 4 < seq.size() && seq[at + 4] == '2';
+                // a move ends at a comma or the end of the sequence, so moves run together,
+                // where a half turn's 2 and the next move's axis would look alike, are refused.
+                let next = at + (half ? 5 : 4);
+                let ended = next == seq.size() || seq[next] == ',' || seq[next] == '\r';
+                let id = valid && ended ? ids[std::stoi(std::string(digits)) + (half ? HALF : 0)] : -1;
+                if (id < 0) {
+                    return false;
                 }
+                moves.push_back(id);
+                at += half ? 4 : 3;
             }
-            std::cout << unsolvedness() << std::endl;
+            return true;
+        };
+        auto line = 0;
+        for (size_t at = 0; at < input.size();) {
+            ++line;
+            let end = std::min(input.find('\n', at), input.size());
+            let text = std::string_view(input).substr(at, end - at);
+            at = end + 1;
+            let gap = std::min(text.find_first_of(" \t"), text.size());
+            let rest = std::min(text.find_first_not_of(" \t", gap), text.size());
+            let start = (uint32_t)moves.size();
+            let ok = parse(text.substr(0, gap));
+            let solution = (uint32_t)moves.size();
+            if (!ok || !parse(text.substr(rest))) {
+                std::cerr << "bad rotation on line " << line << std::endl;
+                return 2;
+            }
+            pairs.push_back(MovePair{start, solution, (uint32_t)moves.size()});
         }
-        std::cout << "solved in " << rotations.size() << " rotations." << std::endl;
     }
-};
-
-auto not_in(dim_t e, const std::span<const dim_t> es) -> bool {
-    return std::find(es.begin(), es.end(), e) == es.end();
-}
 
-auto split(const std::string& string, const char sep) {
-    // consider switching to a search-and-allocate method if push_back becomes a performace bottleneck.
-    std::vector<std::string> result;
-    std::stringstream ss(string);
-    while (ss.good()) {
-        std::string substr;
-        std::getline(ss, substr, sep);
-        result.push_back(substr);
+    let began = std::chrono::steady_clock::now();
+    let failures = verify_all<DIMS>(moves, pairs);
+    let seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+    for (let i : failures) {
+        std::cout << "pair " << i + 1 << " does not solve" << std::endl;
     }
-    return result;
+    std::cerr << pairs.size() << " pairs, " << failures.size() << " failed, "
+              << (size_t)(pairs.size() / std::max(seconds, 1e-9)) << " pairs/s" << std::endl;
+    return failures.empty() ? 0 : 1;
 }
 
+// the state graph of one piece class under some moves, for analysis tools. pieces and moves
+// are lists such as "0-3,6"; moves are ids as --verify reads them, and default to the metric's.
+// without a piece list, the class's first pieces, as many as keep the file within a gigabyte.
 template <dim_t DIMS>
-auto get_rots_from_user() -> std::vector<Rotation> {
-    std::vector<Rotation> result;
-    std::string input;
-    std::cout << "Enter a rotation: ";
-    std::cin >> input;
-    let parts = split(input, ',');
-    for (auto part : parts) {
-        std::array<dim_t, 4> rotparts;
-        auto i = 0;
-        for (char c : part) {
-            rotparts[i++] = (dim_t)c - '0';
+auto cayley(const std::string& path, const PatternSpec& given, const std::optional<std::string>& move_list, Metric metric)
+    -> int {
+    constexpr uint64_t DEFAULT_BYTES = uint64_t{1} << 30;
+    let& table = every_move<DIMS>();
+    std::vector<Rotation> generators;
+    if (move_list) {
+        for (let id : parse_cpulist(*move_list)) {
+            if (id < 0 || (size_t)id >= table.size()) {
+                std::cerr << "no move " << id << std::endl;
+                return 2;
+            }
+            generators.push_back(table.moves[id]);
         }
-        result.push_back(Rotation{ rotparts[0], rotparts[1], rotparts[2], (Side)rotparts[3] });
+    } else {
+        generators = Rotation::all<DIMS>(metric);
     }
-    return result;
+    auto spec = given;
+    uint32_t members = 0;
+    for (size_t idx = 0; idx < (size_t)ipow(3, DIMS); ++idx) {
+        let p = Point<DIMS>::from_index(idx);
+        members += std::count(p.coords.begin(), p.coords.end(), 1) == spec.ones;
+    }
+    if (spec.pieces.empty()) {
+        let bytes = [&](const PatternSpace<DIMS>& space) {
+            let index_bytes = space.size() > UINT32_MAX ? 8 : 4;
+            return (long double)space.size() * generators.size() * index_bytes;
+        };
+        auto trial = spec;
+        while (trial.pieces.size() < std::min<size_t>(members, PatternSpace<DIMS>::MAX_PIECES)) {
+            trial.pieces.push_back(trial.pieces.size());
+            let space = PatternSpace<DIMS>(table, trial);
+            if (!space.fits || bytes(space) > DEFAULT_BYTES) {
+                break;
+            }
+            spec.pieces = trial.pieces;
+        }
+        if (spec.pieces.empty()) {
+            spec.pieces = {0};
+        }
+    }
+    auto sorted = spec.pieces;
+    std::sort(sorted.begin(), sorted.end());
+    if (sorted.empty() || sorted.back() >= members || sorted.size() > PatternSpace<DIMS>::MAX_PIECES ||
+        std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+        std::cerr << "pieces must be distinct members of the class, at most " << PatternSpace<DIMS>::MAX_PIECES << std::endl;
+        return 2;
+    }
+    let began = std::chrono::steady_clock::now();
+    try {
+        export_cayley<DIMS>(path, spec, generators);
+    } catch (const std::system_error& e) {
+        std::cerr << "cannot write the graph: " << e.what() << std::endl;
+        return 2;
+    }
+    let seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+    std::cerr << PatternSpace<DIMS>(table, spec).size() << " states of " << spec.pieces.size() << " pieces, "
+              << generators.size() << " edges each, in " << seconds << "s" << std::endl;
+    return 0;
 }
 
-constexpr auto INIT_DIMS = 2;
-
-auto main() -> int {
-    std::cout << "The N-D Cube (where N is currently " << INIT_DIMS << ")" << std::endl;
-    std::cout << "Enter rotations in the form of four digits (like 1230), where" << std::endl;
-    std::cout << " - the first digit is the axis to rotate around" << std::endl;
-    std::cout << " - the second digit is the axis to rotate from" << std::endl;
-    std::cout << " - the third digit is the axis to rotate to" << std::endl;
-    std::cout << " - the fourth digit is the side to rotate [either 0 or 2]" << std::endl;
-    std::cout << "For example, to rotate the top face clockwise" << std::endl;
-    std::cout << " - we would be rotating around the Y axis (axis 1), " << std::endl;
-    std::cout << " - from the Z axis (2), " << std::endl;
-    std::cout << " - to the X axis (0), " << std::endl;
-    std::cout << " - and we would be rotating the face \"further in the Y direction\" (higher up) (2). " << std::endl;
-    std::cout << "So our command would be 1202." << std::endl;
-
-    auto c = Cube<INIT_DIMS>();
-
-    // c.shuffle(100);
-
-    c.show();
-
-    loop {
-        let rotations = get_rots_from_user<INIT_DIMS>();
+auto usage() -> int {
+    std::cerr << "usage: rubik3 [--dims N] [--warm[=N,N,...]] [--metric M] [--db FILE] [--nodes N]" << std::endl;
+    std::cerr << "              [--batch [--processes P | --goal G | --restricted] [--compound] [--save-db FILE] |" << std::endl;
+    std::cerr << "              --batch (--record FILE | --replay FILE [--serial]) | --verify |" << std::endl;
+    std::cerr << "              --cayley FILE [--class K] [--pieces LIST] [--unoriented] [--moves LIST] | --evaluate[=D] | --layers[=D] |" << std::endl;
+    std::cerr << "              --generators | --track]" << std::endl;
+    std::cerr << "  --dims N   play with an N-dimensional cube (" << MIN_DIMS << " to " << MAX_PLAY_DIMS << ", or " << MAX_DIMS
+              << " to solve)" << std::endl;
+    std::cerr << "  --metric M count moves as quarter (face quarter turns, the default), slice (face and slice" << std::endl;
+    std::cerr << "             quarter turns) or half (face quarter and half turns), and solve in them" << std::endl;
+    std::cerr << "  --batch    solve every scramble on stdin, one per line, using every cpu" << std::endl;
+    std::cerr << "  --processes P  solve the batch in P (1 to 256) worker processes sharing one copy of the tables" << std::endl;
+    std::cerr << "  --goal G   solve the batch only as far as G, e.g. placed=0 (corners placed), oriented," << std::endl;
+    std::cerr << "             face=1,2 (that face solved) or several joined by +" << std::endl;
+    std::cerr << "  --restricted   solve the batch with a small set of the metric's moves that reaches every" << std::endl;
+    std::cerr << "             state, as --generators prints; for cubes too wide to search with every move, as" << std::endl;
+    std::cerr << "             it is slower than --batch in 3D and 4D, and its solutions are not optimal" << std::endl;
+    std::cerr << "  --nodes N  give up on a scramble, as unsolved, once its search has visited N states" << std::endl;
+    std::cerr << "  --compound search the batch two moves at a time, which pays off on the 3D cube" << std::endl;
+    std::cerr << "  --record FILE  solve the batch with the stochastic solver, recording the run to FILE" << std::endl;
+    std::cerr << "  --replay FILE  repeat a recorded run on the same batch, with its threads unless --serial" << std::endl;
+    std::cerr << "  --db FILE  answer from the solutions stored in FILE where it has them" << std::endl;
+    std::cerr << "  --save-db FILE  store the batch's solutions in FILE, for --db" << std::endl;
+    std::cerr << "  --verify   check the (scramble, solution) pairs on stdin, as text or binary" << std::endl;
+    std::cerr << "  --cayley FILE  write the state graph of --pieces (default: as many as fit 1 GiB) of class K (0 for" << std::endl;
+    std::cerr << "             corners) under --moves (move ids, default: the metric's), for mmap; LIST is like 0-3,6" << std::endl;
+    std::cerr << "  --unoriented   ignore the pieces' orientations in the graph" << std::endl;
+    std::cerr << "  --evaluate[=D] score each heuristic on states up to D (default 8) moves from solved" << std::endl;
+    std::cerr << "  --layers[=D]   count the states at each distance from solved, up to D (default 6)" << std::endl;
+    std::cerr << "  --generators   print a small set of the metric's moves that reaches every state" << std::endl;
+    std::cerr << "  --track    follow the moves on stdin as they come, keeping a solution up to date" << std::endl;
+    std::cerr << "  --warm     build the solver tables for N (or the listed dimensions) in the background" << std::endl;
+    return 1;
+}
 
-        for (let r : rotations) {
-            c.rotate(r);
+auto main(int argc, char** argv) -> int {
+    auto dims = INIT_DIMS;
+    std::optional<std::string> warm;
+    auto batch_mode = false;
+    auto verify_mode = false;
+    size_t processes = 0;
+    std::optional<std::string> goal;
+    std::optional<std::string> cayley_path;
+    std::optional<std::string> cayley_moves;
+    std::optional<std::string> record;
+    std::optional<std::string> replay;
+    auto serial = false;
+    std::optional<int> evaluate_depth;
+    std::optional<int> layers_depth;
+    auto generators_mode = false;
+    auto restricted = false;
+    auto track_mode = false;
+    std::optional<std::string> save_db;
+    std::unique_ptr<SolutionDb> db;
+    PatternSpec subpuzzle{0, {}};
+    SolveOptions opts;
+    for (auto i = 1; i < argc; ++i) {
+        let arg = std::string(argv[i]);
+        if (arg == "--dims" && i + 1 < argc) {
+            dims = std::atoi(argv[++i]);
+        } else if (arg == "--batch") {
+            batch_mode = true;
+        } else if (arg == "--verify") {
+            verify_mode = true;
+        } else if (arg == "--goal" && i + 1 < argc) {
+            goal = argv[++i];
+        } else if (arg == "--metric" && i + 1 < argc) {
+            let metric = parse_metric(argv[++i]);
+            if (!metric) {
+                return usage();
+            }
+            opts.metric = *metric;
+        } else if (arg == "--cayley" && i + 1 < argc) {
+            cayley_path = argv[++i];
+        } else if (arg == "--class" && i + 1 < argc) {
+            subpuzzle.ones = std::atoi(argv[++i]);
+        } else if (arg == "--pieces" && i + 1 < argc) {
+            for (let piece : parse_cpulist(argv[++i])) {
+                subpuzzle.pieces.push_back(piece);
+            }
+        } else if (arg == "--unoriented") {
+            subpuzzle.orientation = false;
+        } else if (arg == "--moves" && i + 1 < argc) {
+            cayley_moves = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            record = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay = argv[++i];
+        } else if (arg == "--serial") {
+            serial = true;
+        } else if (arg == "--db" && i + 1 < argc) {
+            try {
+                db = std::make_unique<SolutionDb>(argv[++i]);
+            } catch (const std::system_error& e) {
+                std::cerr << "cannot use the solution database: " << e.what() << std::endl;
+                return 2;
+            }
+            opts.db = db.get();
+        } else if (arg == "--save-db" && i + 1 < argc) {
+            save_db = argv[++i];
+        } else if (arg == "--compound") {
+            opts.compound = true;
+        } else if (arg == "--processes" && i + 1 < argc) {
+            let text = std::string_view(argv[++i]);
+            let end = text.data() + text.size();
+            let [at, error] = std::from_chars(text.data(), end, processes);
+            if (error != std::errc() || at != end || processes == 0 || processes > ProcessPool<3>::MAX_PROCESSES) {
+                return usage();
+            }
+        } else if (arg == "--evaluate") {
+            evaluate_depth = 8;
+        } else if (arg.starts_with("--evaluate=")) {
+            evaluate_depth = std::atoi(arg.c_str() + 11);
+            if (*evaluate_depth < 1) {
+                return usage();
+            }
+        } else if (arg == "--layers") {
+            layers_depth = 6;
+        } else if (arg.starts_with("--layers=")) {
+            layers_depth = std::atoi(arg.c_str() + 9);
+            if (*layers_depth < 1) {
+                return usage();
+            }
+        } else if (arg == "--restricted") {
+            restricted = true;
+        } else if (arg == "--nodes" && i + 1 < argc) {
+            let text = std::string_view(argv[++i]);
+            let end = text.data() + text.size();
+            let [at, error] = std::from_chars(text.data(), end, opts.max_nodes);
+            if (error != std::errc() || at != end || opts.max_nodes == 0) {
+                return usage();
+            }
+        } else if (arg == "--generators") {
+            generators_mode = true;
+        } else if (arg == "--track") {
+            track_mode = true;
+        } else if (arg == "--warm") {
+            warm = "";
+        } else if (arg.starts_with("--warm=")) {
+            warm = arg.substr(7);
+        } else {
+            return usage();
         }
+    }
+    let solving = batch_mode || verify_mode || cayley_path || evaluate_depth || layers_depth || generators_mode || track_mode;
+    if (dims < MIN_DIMS || dims > (solving ? MAX_DIMS : MAX_PLAY_DIMS)) {
+        return usage();
+    }
 
-        c.show();
+    std::vector<std::function<void()>> jobs;
+    if (warm) {
+        let list = warm->empty() ? std::vector{std::to_string(dims)} : split(*warm, ',');
+        for (let& d : list) {
+            let n = std::atoi(d.c_str());
+            if (n < MIN_DIMS || n > MAX_DIMS) {
+                return usage();
+            }
+            jobs.push_back(with_dims(n, [&](auto D) -> std::function<void()> {
+                return [metric = opts.metric] { Tables<decltype(D)::value>::instance(metric).warm(); };
+            }));
+        }
     }
+    let warmup = Warmup(std::move(jobs));
 
-}
\ No newline at end of file
+    if (cayley_path) {
+        if (subpuzzle.ones >= dims) {
+            return usage();
+        }
+        return with_dims(dims, [&](auto D) {
+            return cayley<decltype(D)::value>(*cayley_path, subpuzzle, cayley_moves, opts.metric);
+        });
+    }
+    if (evaluate_depth) {
+        return with_dims(dims, [&](auto D) { return evaluate<decltype(D)::value>(*evaluate_depth, opts.metric); });
+    }
+    if (layers_depth) {
+        return with_dims(dims, [&](auto D) { return layers<decltype(D)::value>(*layers_depth, opts.metric); });
+    }
+    if (generators_mode) {
+        return with_dims(dims, [&](auto D) { return generators<decltype(D)::value>(opts.metric); });
+    }
+    if (track_mode) {
+        return with_dims(dims, [&](auto D) { return track<decltype(D)::value>(opts); });
+    }
+    if (verify_mode) {
+        return with_dims(dims, [](auto D) { return verify<decltype(D)::value>(); });
+    }
+    if (batch_mode && (record || replay)) {
+        if (record && replay) {
+            return usage();
+        }
+        return with_dims(dims, [&](auto D) { return anneal<decltype(D)::value>(record, replay, serial); });
+    }
+    if (batch_mode) {
+        return with_dims(dims, [&](auto D) { return batch<decltype(D)::value>(processes, goal, restricted, opts, save_db); });
+    }
+    return with_dims<MIN_DIMS, MAX_PLAY_DIMS>(dims, [&](auto D) { return interactive<decltype(D)::value>(opts); });
+}
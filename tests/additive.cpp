@@ -0,0 +1,58 @@
+// an additive heuristic, whose members each count the moves of their own axes, finds solutions
+// as short as the maxed default's, and Heuristic::build maxes members that would overcount.
+
+#include "check.hpp"
+
+template <dim_t DIMS>
+auto solve_with(const MoveTable<DIMS>& table, const Heuristic<DIMS>& heuristic, const Cube<DIMS>& cube)
+    -> std::optional<std::vector<Rotation>> {
+    return IdaStar<DIMS>{table, &heuristic, cube}.run(20);
+}
+
+void additive() {
+    let& table = Tables<3>::instance().moves.get();
+    let maxed = Heuristic<3>::build(table, default_heuristic<3>());
+    // corners charged with axes 0 and 1, edges left to take what remains.
+    let summed = Heuristic<3>::build(table,
+        HeuristicSpec{.additive = {{.ones = 0, .pieces = {0, 1, 2}, .axes = {0, 1}},
+                                   {.ones = 1, .pieces = {0, 1, 2}}}});
+    CHECK(summed->num_additive == 2);
+    CHECK(summed->dbs[1].space.spec.axes == std::vector<dim_t>{2});
+
+    auto rng = SplitMix{3};
+    for (size_t n = 0; n < 20; ++n) {
+        Cube<3> cube;
+        for (size_t k = 0; k < 1 + n % 6; ++k) {
+            cube.rotate(table.moves[rng.below(table.size())]);
+        }
+        let expected = solve_with(table, *maxed, cube);
+        let solution = solve_with(table, *summed, cube);
+        CHECK(expected && solution);
+        if (expected && solution) {
+            CHECK(solution->size() == expected->size());
+            for (let r : *solution) {
+                cube.rotate(r);
+            }
+            CHECK(cube.is_solved());
+        }
+    }
+
+    // axis 1 charged twice, axis 7 out of range, and no axis left for the last, so only the
+    // first and the fourth are summed.
+    let refused = Heuristic<3>::build(table,
+        HeuristicSpec{.additive = {{.ones = 0, .pieces = {0, 1}, .axes = {0, 1}},
+                                   {.ones = 0, .pieces = {2, 3}, .axes = {1}},
+                                   {.ones = 0, .pieces = {4, 5}, .axes = {7}},
+                                   {.ones = 1, .pieces = {0, 1}},
+                                   {.ones = 1, .pieces = {2, 3}}}});
+    CHECK(refused->num_additive == 2);
+    CHECK(refused->dbs.size() == 5);
+    for (size_t i = refused->num_additive; i < refused->dbs.size(); ++i) {
+        CHECK(refused->dbs[i].space.spec.axes.empty());
+    }
+}
+
+auto main() -> int {
+    additive();
+    return failures();
+}
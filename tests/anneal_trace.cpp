@@ -0,0 +1,73 @@
+// a batch recorded by anneal_batch replays to the same solutions, serially or on the recorded
+// workers, after a round trip through a file; a trace that was tampered with, or doesn't
+// belong to the cubes, is caught.
+
+#include <sstream>
+
+#include "check.hpp"
+
+template <dim_t DIMS>
+void record_replay(size_t count, size_t max_iterations) {
+    let all = Rotation::all<DIMS>();
+    auto rng = SplitMix{count};
+    std::vector<Cube<DIMS>> cubes(count);
+    for (auto& cube : cubes) {
+        for (auto k = 0; k < 6; ++k) {
+            cube.rotate(all[rng.below(all.size())]);
+        }
+    }
+    AnnealTrace recorded;
+    let solutions = anneal_batch<DIMS>(cubes, 42, recorded, max_iterations);
+    CHECK(solutions.size() == cubes.size());
+    CHECK(recorded.runs.size() == cubes.size());
+
+    std::stringstream file;
+    recorded.save(file);
+    let loaded = AnnealTrace::load(file);
+    CHECK(loaded);
+    if (!loaded) {
+        return;
+    }
+    CHECK(loaded->seed == recorded.seed);
+    CHECK(loaded->workers == recorded.workers);
+    for (size_t i = 0; i < cubes.size(); ++i) {
+        CHECK(loaded->runs[i].seed == recorded.runs[i].seed);
+        CHECK(loaded->runs[i].steps == recorded.runs[i].steps);
+        CHECK(loaded->runs[i].kept == recorded.runs[i].kept);
+    }
+
+    for (let threaded : {false, true}) {
+        let replayed = replay_batch<DIMS>(cubes, *loaded, threaded);
+        CHECK(replayed && *replayed == solutions);
+    }
+
+    // one decision the other way.
+    auto flipped = *loaded;
+    let run = std::find_if(flipped.runs.begin(), flipped.runs.end(), [](let& r) { return r.steps > 0; });
+    CHECK(run != flipped.runs.end());
+    if (run != flipped.runs.end()) {
+        run->kept[0] ^= 1;
+        CHECK(!replay_batch<DIMS>(cubes, flipped, false));
+    }
+
+    // the runs of other cubes.
+    auto others = cubes;
+    std::rotate(others.begin(), others.begin() + 1, others.end());
+    CHECK(!replay_batch<DIMS>(others, *loaded, false));
+
+    // a run given to two workers.
+    auto twice = *loaded;
+    twice.workers.push_back({0});
+    CHECK(!replay_batch<DIMS>(cubes, twice, true));
+
+    // a file cut short.
+    let bytes = file.str();
+    std::stringstream cut(bytes.substr(0, bytes.size() - 1));
+    CHECK(!AnnealTrace::load(cut));
+}
+
+auto main() -> int {
+    record_replay<3>(20, 3000);
+    record_replay<4>(6, 1000);
+    return failures();
+}
@@ -0,0 +1,54 @@
+// BloomFilter never forgets a key, and sized for a rate it stays near it; as count_layers' visited
+// set it finds the quarter turn metric's known counts of states by distance.
+
+#include "check.hpp"
+
+void rate(uint64_t items, double target) {
+    auto filter = BloomFilter::sized_for(items, target);
+    auto rng = SplitMix{items};
+    std::vector<uint64_t> keys(items);
+    for (auto& key : keys) {
+        key = rng.next();
+        filter.insert(key);
+    }
+    for (let key : keys) {
+        CHECK(filter.contains(key));
+    }
+    // fresh keys, from a stream the inserted ones can't come from.
+    constexpr uint64_t PROBES = 2'000'000;
+    auto probes = SplitMix{~items};
+    uint64_t positives = 0;
+    for (uint64_t n = 0; n < PROBES; ++n) {
+        positives += filter.contains(probes.next());
+    }
+    let measured = (double)positives / PROBES;
+    let expected = filter.expected_rate(items);
+    CHECK(expected <= target);
+    // a binomial count, so allow a few standard deviations either side.
+    let slack = 4 * std::sqrt(expected * PROBES) / PROBES;
+    CHECK(std::abs(measured - expected) <= slack);
+}
+
+void new_keys() {
+    BloomFilter filter(1 << 20, 7);
+    CHECK(filter.insert(1));
+    CHECK(!filter.insert(1));
+    CHECK(filter.contains(1));
+    filter.clear();
+    CHECK(!filter.contains(1));
+}
+
+void layers() {
+    auto seen = BloomFilter::sized_for(200'000, 1e-9);
+    let counts = count_layers<3>(5, UINT64_MAX, seen);
+    CHECK((counts == std::vector<uint64_t>{1, 12, 114, 1068, 10011, 93840}));
+}
+
+auto main() -> int {
+    rate(100'000, 0.01);
+    rate(1'000'000, 0.001);
+    rate(50'000, 0.1);
+    new_keys();
+    layers();
+    return failures();
+}
@@ -0,0 +1,30 @@
+// the little the tests need: CHECK reports a condition that doesn't hold and carries on, and
+// main returns failures() so that the exit status says whether everything held.
+#pragma once
+
+#include <iostream>
+
+#include "../ndcube.hpp"
+
+inline auto failures() -> int& {
+    static int count = 0;
+    return count;
+}
+
+#define CHECK(condition)                                                                        \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": failed: " #condition << std::endl; \
+            ++failures();                                                                       \
+        }                                                                                       \
+    } while (false)
+
+template <dim_t DIMS>
+auto same_state(const Cube<DIMS>& a, const Cube<DIMS>& b) -> bool {
+    for (size_t i = 0; i < a.points.size(); ++i) {
+        if (a.points[i].coords != b.points[i].coords || a.points[i].orientation != b.points[i].orientation) {
+            return false;
+        }
+    }
+    return true;
+}
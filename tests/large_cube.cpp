@@ -0,0 +1,44 @@
+// a large cube turns only the slots of the moved layer; every quarter, half and slice turn
+// must leave it where turning each of its points on its own would.
+
+#include "check.hpp"
+
+template <dim_t DIMS>
+void turns_like_points(std::span<const Rotation> moves, size_t count, uint64_t seed) {
+    static_assert(Cube<DIMS>::LARGE);
+    auto rng = SplitMix{seed};
+    Cube<DIMS> cube;
+    std::vector<Point<DIMS>> points(cube.points.begin(), cube.points.end());
+    for (size_t n = 0; n < count; ++n) {
+        let r = moves[rng.below(moves.size())];
+        cube.rotate(r);
+        for (auto& p : points) {
+            p.rotate(r);
+        }
+        auto same = true;
+        for (size_t i = 0; i < points.size(); ++i) {
+            let& p = cube.points[i];
+            same = same && p.coords == points[i].coords && p.orientation == points[i].orientation &&
+                   cube.slots[p.index()] == i;
+        }
+        CHECK(same);
+    }
+}
+
+template <dim_t DIMS>
+void every_kind() {
+    let quarters = Rotation::all<DIMS>();
+    let halves = Rotation::half_turns<DIMS>();
+    auto slices = Rotation::all<DIMS>(Metric::SLICE);
+    std::erase_if(slices, [](let& r) { return r.side != MIDDLE; });
+    turns_like_points<DIMS>(quarters, 30, 1);
+    turns_like_points<DIMS>(halves, 30, 2);
+    turns_like_points<DIMS>(slices, 30, 3);
+    turns_like_points<DIMS>(Rotation::every<DIMS>(), 30, 4);
+}
+
+auto main() -> int {
+    every_kind<9>();
+    every_kind<10>();
+    return failures();
+}
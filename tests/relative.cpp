@@ -0,0 +1,46 @@
+// relative(a, b) is solved exactly when a and b look alike to Cube::is_solved, and
+// solve_between's moves take a to b, no longer than the moves that led from a to b.
+
+#include "check.hpp"
+
+template <dim_t DIMS>
+auto walk(Cube<DIMS> cube, std::span<const Rotation> moves) -> Cube<DIMS> {
+    for (let r : moves) {
+        cube.rotate(r);
+    }
+    return cube;
+}
+
+template <dim_t DIMS>
+void between(size_t count) {
+    let all = Rotation::all<DIMS>();
+    auto rng = SplitMix{DIMS};
+    let random_moves = [&](size_t length) {
+        std::vector<Rotation> moves;
+        for (size_t k = 0; k < length; ++k) {
+            moves.push_back(all[rng.below(all.size())]);
+        }
+        return moves;
+    };
+    for (size_t n = 0; n < count; ++n) {
+        let a = walk(Cube<DIMS>{}, random_moves(30));
+        CHECK(relative(a, a).is_solved());
+        CHECK(!relative(a, Cube<DIMS>{}).is_solved());
+        CHECK(Goal<DIMS>::solved().hash(relative(a, Cube<DIMS>{})) == Goal<DIMS>::solved().hash(a));
+
+        let moves = random_moves(1 + n % 5);
+        let b = walk(a, moves);
+        let solution = solve_between(a, b, SolveOptions{.allow_fallback = false});
+        CHECK(solution);
+        if (solution) {
+            CHECK(solution->size() <= moves.size());
+            CHECK(relative(walk(a, *solution), b).is_solved());
+        }
+    }
+}
+
+auto main() -> int {
+    between<3>(20);
+    between<4>(5);
+    return failures();
+}
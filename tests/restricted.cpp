@@ -0,0 +1,62 @@
+// generating_moves() reaches every state the full set does, and solve_restricted's solutions
+// keep to those moves and give up within their node budget.
+
+#include "check.hpp"
+
+template <dim_t DIMS>
+auto group_of(const std::vector<Rotation>& moves) -> PermutationGroup {
+    std::vector<PermutationGroup::Perm> perms;
+    for (let& r : moves) {
+        perms.push_back(marker_permutation<DIMS>(r));
+    }
+    return PermutationGroup(ipow(3, DIMS) * DIMS, perms);
+}
+
+template <dim_t DIMS>
+void restricted() {
+    let all = Rotation::all<DIMS>();
+    let generators = generating_moves<DIMS>();
+    let among = [&](Rotation r) { return std::find(generators.begin(), generators.end(), r) != generators.end(); };
+    CHECK(generators.size() < all.size());
+    CHECK(std::abs(group_of<DIMS>(generators).log10_order() - group_of<DIMS>(all).log10_order()) < 1e-9);
+
+    let moves = MoveTable<DIMS>::build(generators, Metric::QUARTER);
+    auto rng = SplitMix{DIMS};
+    for (auto n = 0; n < 10; ++n) {
+        Cube<DIMS> cube;
+        for (auto k = 0; k < 5; ++k) {
+            cube.rotate(generators[rng.below(generators.size())]);
+        }
+        let solution = solve_restricted(cube, *moves, SolveOptions{.max_depth = 5, .max_nodes = 10'000'000});
+        CHECK(solution);
+        if (solution) {
+            CHECK(solution->size() <= 5);
+            CHECK(std::all_of(solution->begin(), solution->end(), among));
+            for (let r : *solution) {
+                cube.rotate(r);
+            }
+            CHECK(cube.is_solved());
+        }
+    }
+
+    // a dropped move takes several generators in its place: three in 4D, and in 3D, where a
+    // whole face is dropped, more than a small budget reaches.
+    let dropped = std::find_if(all.begin(), all.end(), [&](Rotation r) { return !among(r); });
+    Cube<DIMS> cube;
+    cube.rotate(*dropped);
+    let began = std::chrono::steady_clock::now();
+    let solution = solve_restricted(cube, *moves, SolveOptions{.max_nodes = 1000});
+    CHECK(std::chrono::steady_clock::now() - began < std::chrono::seconds(1));
+    if constexpr (DIMS == 3) {
+        CHECK(!solution);
+    } else {
+        CHECK(solution && solution->size() > 1);
+        CHECK(solution && std::all_of(solution->begin(), solution->end(), among));
+    }
+}
+
+auto main() -> int {
+    restricted<3>();
+    restricted<4>();
+    return failures();
+}
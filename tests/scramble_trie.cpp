@@ -0,0 +1,56 @@
+// ScrambleTrie gives every scramble the state that applying its moves one by one does, shared
+// prefixes, repeats and empty scrambles included, and applies each shared move only once.
+
+#include "check.hpp"
+
+template <dim_t DIMS>
+void against_direct(size_t count) {
+    let all = Rotation::every<DIMS>();
+    auto rng = SplitMix{DIMS * 1000 + count};
+    std::vector<std::vector<Rotation>> scrambles;
+    for (size_t n = 0; n < count; ++n) {
+        // most share a prefix with an earlier one, as batches of related scrambles do.
+        std::vector<Rotation> scramble;
+        if (!scrambles.empty() && rng.below(4) != 0) {
+            let& earlier = scrambles[rng.below(scrambles.size())];
+            scramble.assign(earlier.begin(), earlier.begin() + rng.below(earlier.size() + 1));
+        }
+        for (auto k = rng.below(8); k > 0; --k) {
+            scramble.push_back(all[rng.below(all.size())]);
+        }
+        scrambles.push_back(scramble);
+    }
+    scrambles.push_back({});
+    scrambles.push_back(scrambles[0]);
+
+    ScrambleTrie<DIMS> trie;
+    size_t moves = 0;
+    for (size_t n = 0; n < scrambles.size(); ++n) {
+        CHECK(trie.insert(scrambles[n]) == n);
+        moves += scrambles[n].size();
+    }
+    CHECK(trie.size() == scrambles.size());
+    CHECK(trie.moves() == moves);
+    // scrambles[0] twice, if nothing else, shares moves.
+    CHECK(trie.applied() < moves || scrambles[0].empty());
+
+    let states = trie.states();
+    std::vector<size_t> visits(scrambles.size(), 0);
+    trie.each([&](size_t index, const Cube<DIMS>&) { ++visits[index]; });
+    for (size_t n = 0; n < scrambles.size(); ++n) {
+        Cube<DIMS> cube;
+        for (let r : scrambles[n]) {
+            cube.rotate(r);
+        }
+        CHECK(same_state(states[n], cube));
+        CHECK(visits[n] == 1);
+    }
+}
+
+auto main() -> int {
+    against_direct<3>(1);
+    against_direct<3>(500);
+    against_direct<4>(300);
+    against_direct<5>(50);
+    return failures();
+}
@@ -0,0 +1,60 @@
+// SequenceIndex numbers the canonical move sequences of a length without gaps: unrank and rank
+// undo each other, ranges step through them in order, and shares cover them exactly.
+
+#include <set>
+
+#include "check.hpp"
+
+template <dim_t DIMS>
+void round_trip(Metric metric, size_t length, const std::vector<uint64_t>& counts) {
+    let table = MoveTable<DIMS>::build(metric);
+    for (size_t k = 0; k < counts.size(); ++k) {
+        CHECK(SequenceIndex<DIMS>(*table, k).count() == counts[k]);
+    }
+
+    let index = SequenceIndex<DIMS>(*table, length);
+    std::set<std::vector<uint16_t>> seen;
+    for (uint64_t i = 0; i < index.count(); ++i) {
+        let sequence = index.unrank(i);
+        CHECK(sequence.size() == length);
+        CHECK(index.rank(sequence) == i);
+        for (size_t k = 1; k < sequence.size(); ++k) {
+            CHECK(table->follows(sequence[k - 1], sequence[k]));
+        }
+        seen.insert(sequence);
+    }
+    CHECK(seen.size() == index.count());
+
+    // stepping in place gives what unranking does, from any starting point.
+    for (let& [begin, end] : {std::pair<uint64_t, uint64_t>{0, 50}, {index.count() / 3, index.count() / 3 + 200},
+                             {index.count() - 7, index.count() + 10}}) {
+        auto i = begin;
+        for (let sequence : index.range(begin, end)) {
+            CHECK(std::ranges::equal(sequence, index.unrank(i)));
+            ++i;
+        }
+        CHECK(i == std::min(end, index.count()));
+    }
+
+    uint64_t covered = 0;
+    for (size_t part = 0; part < 7; ++part) {
+        let [begin, end] = index.share(part, 7);
+        CHECK(begin == covered);
+        covered = end;
+    }
+    CHECK(covered == index.count());
+
+    // a sequence that isn't canonical has no number: here a move and its inverse.
+    if (length >= 2) {
+        std::vector<uint16_t> undone(length, 0);
+        undone[1] = table->inverses[0];
+        CHECK(!index.rank(undone));
+    }
+}
+
+auto main() -> int {
+    round_trip<3>(Metric::QUARTER, 4, {1, 12, 114, 1068, 10011, 93840});
+    round_trip<3>(Metric::HALF, 3, {1, 18, 243, 3240, 43254});
+    round_trip<4>(Metric::QUARTER, 2, {1, 48});
+    return failures();
+}
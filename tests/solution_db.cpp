@@ -0,0 +1,92 @@
+// a SolutionDb written by write_solution_db finds every state it was given, with the shortest
+// solution given for it, and nothing else; whatever the number of entries, as the eytzinger
+// descent has to land right on trees that are not full.
+
+#include <cstdio>
+#include <filesystem>
+
+#include "check.hpp"
+
+auto inverse_of(const std::vector<Rotation>& moves) -> std::vector<Rotation> {
+    std::vector<Rotation> inverse;
+    for (auto r = moves.rbegin(); r != moves.rend(); ++r) {
+        inverse.push_back(r->inverse());
+    }
+    return inverse;
+}
+
+template <dim_t DIMS>
+void round_trip(size_t count, const std::string& path) {
+    let all = Rotation::all<DIMS>();
+    auto rng = SplitMix{count};
+    std::vector<Cube<DIMS>> cubes;
+    std::vector<std::vector<Rotation>> solutions;
+    for (size_t n = 0; n < count; ++n) {
+        std::vector<Rotation> scramble;
+        for (auto k = 0; k < 12; ++k) {
+            scramble.push_back(all[rng.below(all.size())]);
+        }
+        Cube<DIMS> cube;
+        for (let r : scramble) {
+            cube.rotate(r);
+        }
+        cubes.push_back(cube);
+        solutions.push_back(inverse_of(scramble));
+    }
+    // the same states again, with longer solutions that should lose to the first ones.
+    for (size_t n = 0; n < count; n += 3) {
+        cubes.push_back(cubes[n]);
+        auto longer = solutions[n];
+        longer.push_back(all[0]);
+        longer.push_back(all[0].inverse());
+        solutions.push_back(longer);
+    }
+    write_solution_db<DIMS>(path, cubes, solutions, Metric::QUARTER);
+
+    let db = SolutionDb(path);
+    CHECK(db.size() == count);
+    for (size_t n = 0; n < count; ++n) {
+        let found = db.lookup(cubes[n], Metric::QUARTER);
+        CHECK(found && found->size() == solutions[n].size());
+        if (found) {
+            auto cube = cubes[n];
+            for (let r : *found) {
+                cube.rotate(r);
+            }
+            CHECK(cube.is_solved());
+        }
+        CHECK(!db.lookup(cubes[n], Metric::HALF));
+    }
+    // states that weren't stored, and a database for another cube.
+    for (auto n = 0; n < 20; ++n) {
+        Cube<DIMS> cube;
+        for (auto k = 0; k < 13; ++k) {
+            cube.rotate(all[rng.below(all.size())]);
+        }
+        CHECK(!db.lookup(cube, Metric::QUARTER));
+    }
+    CHECK(!db.lookup(Cube<DIMS + 1>{}, Metric::QUARTER));
+}
+
+auto main() -> int {
+    let path = (std::filesystem::temp_directory_path() / ("ndcube-db-" + std::to_string(getpid()))).string();
+    for (size_t count : {1, 2, 3, 7, 8, 9, 15, 16, 17, 100, 1000}) {
+        round_trip<3>(count, path);
+    }
+    round_trip<4>(200, path);
+
+    // anything that isn't a database is refused when opened, not when looked up.
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "NDCS but not much else";
+    }
+    auto refused = false;
+    try {
+        SolutionDb db(path);
+    } catch (const std::system_error&) {
+        refused = true;
+    }
+    CHECK(refused);
+    std::remove(path.c_str());
+    return failures();
+}
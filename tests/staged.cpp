@@ -0,0 +1,60 @@
+// solve_to stops as soon as its goal holds, and solve_staged reaches each of its goals in turn
+// on the way to the last.
+
+#include "check.hpp"
+
+template <dim_t DIMS>
+void staged(size_t count) {
+    let all = Rotation::all<DIMS>();
+    let face_terms = std::vector{GoalTerm{.face = std::pair{(dim_t)0, FRONT}}};
+    let placed_terms = std::vector{face_terms[0], GoalTerm{.ones = 0, .orientation = false}};
+    let face = Goal<DIMS>::compile(face_terms);
+    let placed = Goal<DIMS>::compile(placed_terms);
+    let solved = Goal<DIMS>::solved();
+    let stages = std::vector{face, placed, solved};
+    auto rng = SplitMix{DIMS};
+    for (size_t n = 0; n < count; ++n) {
+        Cube<DIMS> cube;
+        for (auto k = 0; k < 6; ++k) {
+            cube.rotate(all[rng.below(all.size())]);
+        }
+
+        let to_face = solve_to(cube, face);
+        CHECK(to_face && to_face->size() <= 6);
+        if (to_face) {
+            auto scratch = cube;
+            for (size_t i = 0; i < to_face->size(); ++i) {
+                // nothing short of the end already has the face.
+                CHECK(!face.holds(scratch));
+                scratch.rotate((*to_face)[i]);
+            }
+            CHECK(face.holds(scratch));
+        }
+
+        let solution = solve_staged<DIMS>(cube, stages);
+        CHECK(solution);
+        if (solution) {
+            // the goals first hold in the order they were given.
+            size_t next = 0;
+            auto scratch = cube;
+            let reached = [&] {
+                while (next < stages.size() && stages[next].holds(scratch)) {
+                    ++next;
+                }
+            };
+            reached();
+            for (let r : *solution) {
+                scratch.rotate(r);
+                reached();
+            }
+            CHECK(next == stages.size());
+            CHECK(scratch.is_solved());
+        }
+    }
+}
+
+auto main() -> int {
+    staged<3>(10);
+    staged<4>(1);
+    return failures();
+}
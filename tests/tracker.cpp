@@ -0,0 +1,84 @@
+// Tracker keeps a solution of the state it follows, and neither its destructor nor a new move
+// waits on a background solve that has no end in sight.
+
+#include "check.hpp"
+
+using namespace std::chrono_literals;
+
+template <dim_t DIMS>
+auto solves(const Cube<DIMS>& state, const std::vector<Rotation>& solution) -> bool {
+    auto cube = state;
+    for (let r : solution) {
+        cube.rotate(r);
+    }
+    return cube.is_solved();
+}
+
+// moves from a long walk, far enough out that an optimal solve takes much longer than the test.
+auto far_moves(size_t count) -> std::vector<Rotation> {
+    let all = Rotation::all<3>();
+    auto rng = SplitMix{7};
+    std::vector<Rotation> moves;
+    for (size_t k = 0; k < count; ++k) {
+        moves.push_back(all[rng.below(all.size())]);
+    }
+    return moves;
+}
+
+void cancels_on_destruction() {
+    let began = std::chrono::steady_clock::now();
+    {
+        Tracker<3> tracker({}, 0ms);
+        for (let r : far_moves(40)) {
+            tracker.apply(r);
+        }
+        CHECK(solves(tracker.state(), tracker.solution()));
+        std::this_thread::sleep_for(100ms);
+    }
+    CHECK(std::chrono::steady_clock::now() - began < 2s);
+}
+
+void cancels_on_a_new_move() {
+    Tracker<3> tracker({}, 0ms);
+    for (let r : far_moves(40)) {
+        tracker.apply(r);
+    }
+    std::this_thread::sleep_for(100ms);
+    // undoing the walk leaves a state a short solve away, which is only found once the long one
+    // gives way to it.
+    let began = std::chrono::steady_clock::now();
+    let walk = far_moves(40);
+    for (auto r = walk.rbegin(); r != walk.rend(); ++r) {
+        tracker.apply(r->inverse());
+    }
+    tracker.wait();
+    CHECK(std::chrono::steady_clock::now() - began < 2s);
+    CHECK(tracker.state().is_solved());
+    CHECK(tracker.optimal());
+    CHECK(tracker.length() == 0);
+}
+
+void short_scrambles() {
+    let all = Rotation::all<3>();
+    auto rng = SplitMix{3};
+    for (auto round = 0; round < 5; ++round) {
+        Tracker<3> tracker({}, 0ms);
+        for (auto k = 0; k < 6; ++k) {
+            tracker.apply(all[rng.below(all.size())]);
+            CHECK(solves(tracker.state(), tracker.solution()));
+        }
+        tracker.wait();
+        CHECK(tracker.optimal());
+        CHECK(solves(tracker.state(), tracker.solution()));
+        CHECK(tracker.length() <= 6);
+    }
+}
+
+auto main() -> int {
+    // the tables take a while to build, and a solve can't be cancelled while it waits for them.
+    Tables<3>::instance(Metric::QUARTER).warm();
+    cancels_on_destruction();
+    cancels_on_a_new_move();
+    short_scrambles();
+    return failures();
+}
@@ -0,0 +1,50 @@
+// Trajectory keeps every state of a run of moves, whichever way round its half turns are written.
+
+#include "check.hpp"
+
+template <dim_t DIMS>
+void replays(size_t interval) {
+    auto rng = SplitMix{DIMS * 100 + interval};
+    let all = Rotation::every<DIMS>();
+    Trajectory<DIMS> trajectory(Cube<DIMS>{}, interval);
+    std::vector<Cube<DIMS>> states = {Cube<DIMS>{}};
+    for (auto k = 0; k < 200; ++k) {
+        auto r = all[rng.below(all.size())];
+        // half turns both ways round, and quarter turns both ways too.
+        if (rng.below(2)) {
+            r = r.turns == 2 ? Rotation{r.axis, r.to, r.from, r.side, 2} : r.inverse();
+        }
+        trajectory.push(r);
+        states.push_back(states.back());
+        states.back().rotate(r);
+    }
+    CHECK(trajectory.size() == states.size());
+    for (size_t step = 0; step < states.size(); ++step) {
+        CHECK(same_state(trajectory.at(step), states[step]));
+    }
+    for (auto k = 0; k < 70; ++k) {
+        trajectory.pop();
+        states.pop_back();
+        CHECK(same_state(trajectory.back(), states.back()));
+    }
+    for (size_t step = 0; step < states.size(); ++step) {
+        CHECK(same_state(trajectory.at(step), states[step]));
+    }
+}
+
+auto main() -> int {
+    // both spellings of a half turn name the same move.
+    let half = Rotation{0, 1, 2, FRONT, 2};
+    Trajectory<3> trajectory(Cube<3>{});
+    trajectory.push(half);
+    trajectory.push(Rotation{0, 2, 1, FRONT, 2});
+    CHECK(trajectory.moves()[0] == trajectory.moves()[1]);
+    CHECK(trajectory.move(1) == half);
+    CHECK(trajectory.back().is_solved());
+
+    replays<3>(1);
+    replays<3>(7);
+    replays<3>(Trajectory<3>::DEFAULT_INTERVAL);
+    replays<4>(16);
+    return failures();
+}